@@ -0,0 +1,130 @@
+/**
+  * Micro-benchmarks for the message bus.
+  *
+  * Measures the cost of the most performance critical paths of MicroBitMessageBus.cpp, with a number of listeners
+  * registered to represent a program with many event handlers and BLE event service subscriptions:
+  *
+  * - process: cycles for process() to deliver an event to the one listener that matches it ("hit"), or to find that
+  *   no listener matches it ("miss").
+  * - send: cycles for send() to run any urgent listeners and queue an event for later processing.
+  *
+  * The event-benchmark-unindexed build is configured with MESSAGE_BUS_LISTENER_BUCKETS set to 0, so holds all
+  * listeners on a single list, for comparison.
+  *
+  * See MicroBitBenchmark.h for details on how to run this on the host and on a micro:bit.
+  */
+
+#include "MicroBitBenchmark.h"
+
+// Events raised by the benchmark. Each source has a listener for each of EVENT_VALUES values.
+#define BENCHMARK_ID                    4000
+#define EVENT_SOURCES                   22
+#define EVENT_VALUES                    2
+
+// Number of listeners to MICROBIT_ID_ANY, which must be considered for every event.
+#define EVENT_WILDCARDS                 2
+
+#define EVENT_ITERATIONS                1000
+
+// Number of events sent before they are processed, so that the event queue never fills.
+#define SEND_BATCH                      8
+
+static int handled = 0;
+
+static void onEvent(MicroBitEvent)
+{
+    handled++;
+}
+
+/**
+  * Registers the benchmark's listeners.
+  * @return The number of listeners registered.
+  */
+static int listeners_register()
+{
+    int count = 0;
+
+    for (int i = 0; i < EVENT_SOURCES; i++)
+        for (int j = 1; j <= EVENT_VALUES; j++)
+            if (uBit.MessageBus.listen(BENCHMARK_ID + i, j, onEvent, MESSAGE_BUS_LISTENER_NONBLOCKING) == MICROBIT_OK)
+                count++;
+
+    for (int i = 0; i < EVENT_WILDCARDS; i++)
+        if (uBit.MessageBus.listen(MICROBIT_ID_ANY, BENCHMARK_ID + i, onEvent, MESSAGE_BUS_LISTENER_NONBLOCKING) == MICROBIT_OK)
+            count++;
+
+    return count;
+}
+
+/**
+  * process() of an event from the given range of sources.
+  */
+static void benchmark_process(const char *name, uint16_t source)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+
+    for (int i = 0; i < EVENT_ITERATIONS; i++)
+    {
+        MicroBitEvent evt(source + i % EVENT_SOURCES, 1, CREATE_ONLY);
+
+        uint32_t start = benchmark_cycles();
+        uBit.MessageBus.process(evt);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+    }
+
+    benchmark_print(result);
+}
+
+/**
+  * send() of an event with one matching listener.
+  */
+static void benchmark_send(const char *name)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+
+    for (int i = 0; i < EVENT_ITERATIONS; i++)
+    {
+        MicroBitEvent evt(BENCHMARK_ID + i % EVENT_SOURCES, 1, CREATE_ONLY);
+
+        uint32_t start = benchmark_cycles();
+        uBit.MessageBus.send(evt);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+
+        // Let the message bus process the events queued so far.
+        if (i % SEND_BATCH == SEND_BATCH - 1)
+            uBit.sleep(0);
+    }
+
+    benchmark_print(result);
+}
+
+void app_main()
+{
+    char name[32];
+
+    benchmark_init();
+
+    uBit.serial.printf("micro:bit runtime %s: event benchmarks (%s)\n", uBit.systemVersion(), MESSAGE_BUS_LISTENER_BUCKETS ? "indexed" : "unindexed");
+    benchmark_print_header();
+
+    int listeners = listeners_register();
+
+    sprintf(name, "process/%d hit", listeners);
+    benchmark_process(name, BENCHMARK_ID);
+
+    sprintf(name, "process/%d miss", listeners);
+    benchmark_process(name, BENCHMARK_ID + EVENT_SOURCES);
+
+    sprintf(name, "send/%d", listeners);
+    benchmark_send(name);
+
+    benchmark_complete();
+}
@@ -0,0 +1,302 @@
+/**
+  * Micro-benchmarks for the heap allocator.
+  *
+  * Measures the cost of the most performance critical paths of MicroBitHeapAllocator.cpp, on a heap that
+  * already holds a number of live blocks of mixed sizes, with free space scattered between them:
+  *
+  * - malloc/free: cycles for microbit_malloc() and microbit_free() of a single block, for a range of sizes.
+  *   12 bytes is the size of a MicroBitEventQueueItem, 100 bytes is about the size of a Fiber, and 256 bytes
+  *   is larger than any size class.
+  * - heap_statistics: cycles for microbit_heap_statistics() of the nested heap, as polled by telemetry.
+  * - churn (host only): the longest period interrupts are held off while blocks of random sizes are
+  *   repeatedly allocated and freed ("irq-off"), along with the cost of each operation ("ops").
+  * - compact (MICROBIT_HEAP_RELOCATABLE only, see heap-benchmark-relocatable): cycles and bytes moved by
+  *   microbit_heap_compact() on a heap fragmented by ManagedString churn. Also reports the largest free space
+  *   before and after the processor is next idle, and whether an allocation twice the size of the largest
+  *   free space before compaction is then served by the heap.
+  *
+  * See MicroBitBenchmark.h for details on how to run this on the host and on a micro:bit.
+  */
+
+#include "MicroBitBenchmark.h"
+
+#define HEAP_ITERATIONS                 1000
+#define CHURN_ITERATIONS                4000
+
+// Number of live blocks held on the heap throughout, to represent a running program.
+#define HEAP_LIVE_BLOCKS                64
+
+// Number of blocks held by the churn benchmark at once.
+#define CHURN_BLOCKS                    32
+
+// Number of strings the compaction benchmark churns (each takes a relocatable handle), and rounds of churn.
+#define COMPACT_STRINGS                 24
+#define COMPACT_ROUNDS                  8
+
+static const int liveSizes[] = { 12, 20, 36, 100, 48, 16 };
+static const int churnSizes[] = { 12, 12, 12, 16, 20, 32, 48, 100, 180, 256 };
+
+static void *liveBlocks[HEAP_LIVE_BLOCKS];
+static void *churnBlocks[CHURN_BLOCKS];
+
+/**
+  * Fills the heap with live blocks of mixed sizes, then frees every other one so that free space is
+  * scattered between them.
+  */
+static void heap_populate()
+{
+    for (int i = 0; i < HEAP_LIVE_BLOCKS; i++)
+        liveBlocks[i] = malloc(liveSizes[i % (sizeof(liveSizes) / sizeof(int))]);
+
+    for (int i = 0; i < HEAP_LIVE_BLOCKS; i += 2)
+    {
+        free(liveBlocks[i]);
+        liveBlocks[i] = NULL;
+    }
+}
+
+/**
+  * Releases the live blocks allocated by heap_populate().
+  */
+static void heap_release()
+{
+    for (int i = 0; i < HEAP_LIVE_BLOCKS; i++)
+        free(liveBlocks[i]);
+}
+
+/**
+  * microbit_malloc() and microbit_free() of a single block of the given size.
+  */
+static void benchmark_malloc_free(const char *mallocName, const char *freeName, int size)
+{
+    BenchmarkResult mallocResult;
+    BenchmarkResult freeResult;
+
+    benchmark_reset(mallocResult, mallocName);
+    benchmark_reset(freeResult, freeName);
+
+    for (int i = 0; i < HEAP_ITERATIONS; i++)
+    {
+        uint32_t start = benchmark_cycles();
+        void *p = malloc(size);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(mallocResult, start, end);
+
+        start = benchmark_cycles();
+        free(p);
+        end = benchmark_cycles();
+
+        benchmark_record(freeResult, start, end);
+    }
+
+    mallocResult.totalBytes = (uint64_t) size * HEAP_ITERATIONS;
+    mallocResult.allocations = HEAP_ITERATIONS;
+
+    benchmark_print(mallocResult);
+    benchmark_print(freeResult);
+}
+
+/**
+  * microbit_heap_statistics() of the nested heap.
+  */
+static void benchmark_heap_statistics(const char *name)
+{
+    BenchmarkResult result;
+    HeapStatistics stats;
+
+    benchmark_reset(result, name);
+
+    for (int i = 0; i < HEAP_ITERATIONS; i++)
+    {
+        uint32_t start = benchmark_cycles();
+        microbit_heap_statistics(0, &stats);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+    }
+
+    benchmark_print(result);
+}
+
+#ifdef MICROBIT_HOST
+
+/**
+  * Random allocations and frees of mixed sizes, holding up to CHURN_BLOCKS blocks at once.
+  */
+static void benchmark_churn(const char *irqName, const char *opsName)
+{
+    BenchmarkResult result;
+    HostIrqStatistics stats;
+    uint32_t seed = 1;
+
+    benchmark_reset(result, opsName);
+    memset(churnBlocks, 0, sizeof(churnBlocks));
+
+    host_irq_statistics_reset();
+
+    for (int i = 0; i < CHURN_ITERATIONS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+
+        int slot = (seed >> 16) % CHURN_BLOCKS;
+        int size = churnSizes[(seed >> 8) % (sizeof(churnSizes) / sizeof(int))];
+
+        uint32_t start = benchmark_cycles();
+
+        if (churnBlocks[slot])
+        {
+            free(churnBlocks[slot]);
+            churnBlocks[slot] = NULL;
+        }
+        else
+        {
+            churnBlocks[slot] = malloc(size);
+            result.totalBytes += size;
+            result.allocations++;
+        }
+
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+    }
+
+    host_irq_statistics(&stats);
+
+    for (int i = 0; i < CHURN_BLOCKS; i++)
+        free(churnBlocks[i]);
+
+    BenchmarkResult irqResult;
+
+    benchmark_reset(irqResult, irqName);
+    irqResult.count = stats.disableCount;
+    irqResult.totalCycles = stats.totalCycles;
+    irqResult.minCycles = 0;
+    irqResult.maxCycles = stats.maxCycles;
+
+    benchmark_print(irqResult);
+    benchmark_print(result);
+}
+
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+
+static ManagedString compactStrings[COMPACT_STRINGS];
+
+/**
+  * Fragments the heap by churning ManagedStrings of varying lengths, that together fill most of the heap,
+  * then releases every other one.
+  */
+static void compact_fragment()
+{
+    HeapStatistics stats;
+    uint32_t seed = 1;
+
+    microbit_heap_statistics(0, &stats);
+
+    int length = stats.largestFree / (COMPACT_STRINGS + COMPACT_STRINGS / 4);
+    char *text = (char *) malloc(length + 1);
+    memset(text, 'x', length);
+
+    for (int round = 0; round < COMPACT_ROUNDS; round++)
+    {
+        for (int i = 0; i < COMPACT_STRINGS; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            compactStrings[i] = ManagedString(text, length - (seed >> 16) % (length / 4));
+        }
+    }
+
+    free(text);
+
+    for (int i = 0; i < COMPACT_STRINGS; i += 2)
+        compactStrings[i] = ManagedString();
+}
+
+/**
+  * Releases the strings left by compact_fragment().
+  */
+static void compact_release()
+{
+    for (int i = 0; i < COMPACT_STRINGS; i++)
+        compactStrings[i] = ManagedString();
+}
+
+/**
+  * microbit_heap_compact() of a heap fragmented by ManagedString churn, and a check that once the processor
+  * has been idle, the heap can serve an allocation larger than the largest free space it had beforehand.
+  */
+static void benchmark_compact(const char *name)
+{
+    BenchmarkResult result;
+    HeapStatistics before;
+    HeapStatistics after;
+    HeapStatistics served;
+
+    benchmark_reset(result, name);
+
+    // Let the scheduler compact the heap, as it does whenever the processor is idle.
+    compact_fragment();
+    microbit_heap_statistics(0, &before);
+
+    int size = before.largestFree * 2;
+
+    fiber_sleep(10);
+
+    microbit_heap_statistics(0, &after);
+    void *p = malloc(size);
+    microbit_heap_statistics(0, &served);
+    free(p);
+
+    compact_release();
+
+    bool ok = served.failures == after.failures;
+
+    // Then measure compaction itself, on the same fragmentation.
+    compact_fragment();
+
+    uint32_t start = benchmark_cycles();
+    int moved = microbit_heap_compact();
+    uint32_t end = benchmark_cycles();
+
+    compact_release();
+
+    benchmark_record(result, start, end);
+    result.totalBytes = moved;
+
+    benchmark_print(result);
+
+    uBit.serial.printf("compact: largest free %d -> %d bytes after idle, %d byte allocation %s\n",
+        before.largestFree, after.largestFree, size, ok ? "served by the heap" : "FAILED");
+}
+
+#endif
+
+void app_main()
+{
+    benchmark_init();
+
+    uBit.serial.printf("micro:bit runtime %s: heap benchmarks\n", uBit.systemVersion());
+    benchmark_print_header();
+
+    heap_populate();
+
+    benchmark_malloc_free("malloc/12", "free/12", 12);
+    benchmark_malloc_free("malloc/32", "free/32", 32);
+    benchmark_malloc_free("malloc/100", "free/100", 100);
+    benchmark_malloc_free("malloc/256", "free/256", 256);
+    benchmark_heap_statistics("heap_statistics");
+
+#ifdef MICROBIT_HOST
+    benchmark_churn("churn irq-off", "churn ops");
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+    benchmark_compact("compact");
+#endif
+
+    heap_release();
+
+    benchmark_complete();
+}
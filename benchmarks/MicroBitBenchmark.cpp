@@ -0,0 +1,108 @@
+#include "MicroBitBenchmark.h"
+
+// The cost of reading the cycle counter twice. Subtracted from every measurement.
+static uint32_t benchmarkOverhead = 0;
+
+/**
+  * Initialises the cycle counter, and measures its own overhead.
+  * Must be called before any other benchmark function.
+  */
+void benchmark_init()
+{
+    benchmark_timer_init();
+
+#ifndef MICROBIT_HOST
+    uBit.serial.baud(115200);
+#endif
+
+    benchmarkOverhead = 0xFFFFFFFF;
+
+    for (int i = 0; i < 100; i++)
+    {
+        uint32_t start = benchmark_cycles();
+        uint32_t end = benchmark_cycles();
+
+        uint32_t cycles = benchmark_elapsed(start, end);
+
+        if (cycles < benchmarkOverhead)
+            benchmarkOverhead = cycles;
+    }
+}
+
+/**
+  * Resets the given benchmark result, ready to record a new benchmark.
+  *
+  * @param result The result to reset.
+  * @param name The name of the benchmark.
+  */
+void benchmark_reset(BenchmarkResult &result, const char *name)
+{
+    result.name = name;
+    result.count = 0;
+    result.totalCycles = 0;
+    result.minCycles = 0xFFFFFFFF;
+    result.maxCycles = 0;
+    result.totalBytes = 0;
+    result.allocations = 0;
+}
+
+/**
+  * Records a single operation.
+  *
+  * @param result The benchmark to record against.
+  * @param start The value of benchmark_cycles() at the start of the operation.
+  * @param end The value of benchmark_cycles() at the end of the operation.
+  */
+void benchmark_record(BenchmarkResult &result, uint32_t start, uint32_t end)
+{
+    uint32_t cycles = benchmark_elapsed(start, end);
+
+    cycles = cycles > benchmarkOverhead ? cycles - benchmarkOverhead : 0;
+
+    result.count++;
+    result.totalCycles += cycles;
+
+    if (cycles < result.minCycles)
+        result.minCycles = cycles;
+
+    if (cycles > result.maxCycles)
+        result.maxCycles = cycles;
+}
+
+/**
+  * Prints the header of a table of benchmark results over serial.
+  */
+void benchmark_print_header()
+{
+    uBit.serial.printf("%-32s %8s %10s %10s %10s %12s %10s\n", "benchmark", "count", "mean", "min", "max", "bytes/op", "allocs");
+}
+
+/**
+  * Prints the given benchmark result over serial.
+  */
+void benchmark_print(BenchmarkResult &result)
+{
+    uint32_t count = result.count ? result.count : 1;
+
+    uBit.serial.printf("%-32s %8lu %10lu %10lu %10lu %12lu %10lu\n", result.name,
+            (unsigned long) result.count,
+            (unsigned long) (result.totalCycles / count),
+            (unsigned long) (result.count ? result.minCycles : 0),
+            (unsigned long) result.maxCycles,
+            (unsigned long) (result.totalBytes / count),
+            (unsigned long) result.allocations);
+}
+
+/**
+  * Ends the benchmark run. On the host this terminates the simulation, otherwise it simply
+  * displays a tick on the LED matrix.
+  */
+void benchmark_complete()
+{
+#ifdef MICROBIT_HOST
+    host_exit(0);
+#else
+    MicroBitImage tick("0,0,0,0,0\n0,0,0,0,255\n0,0,0,255,0\n255,0,255,0,0\n0,255,0,0,0\n");
+    uBit.display.print(tick);
+#endif
+}
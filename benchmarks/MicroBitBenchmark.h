@@ -0,0 +1,113 @@
+/**
+  * Support code for micro:bit runtime benchmarks.
+  *
+  * Benchmarks are ordinary micro:bit programs (they implement app_main()), and can be run either:
+  *
+  * 1) Under the host simulation: these are built by host/CMakeLists.txt, and report host CPU cycles.
+  * 2) On a micro:bit: copy the benchmark, along with MicroBitBenchmark.h/.cpp, into the source folder of a
+  *    yotta application. Results are reported over serial (115200 baud).
+  *
+  * The Cortex M0 has no DWT cycle counter, so on the device cycles are measured with SysTick running
+  * from the 16MHz core clock. SysTick is only 24 bits wide, so individual measurements must be shorter
+  * than ~1ms. Benchmarks therefore time each operation individually, and accumulate the results.
+  */
+
+#ifndef MICROBIT_BENCHMARK_H
+#define MICROBIT_BENCHMARK_H
+
+#include "MicroBit.h"
+
+/**
+  * Results of a single benchmark.
+  */
+struct BenchmarkResult
+{
+    const char  *name;              // Name of the benchmark.
+    uint32_t    count;              // Number of operations measured.
+    uint64_t    totalCycles;        // Total cycles spent in all operations.
+    uint32_t    minCycles;          // Cheapest operation, in cycles.
+    uint32_t    maxCycles;          // Most expensive operation, in cycles.
+    uint64_t    totalBytes;         // Total stack bytes copied by all operations.
+    uint32_t    allocations;        // Number of heap allocations made by all operations.
+};
+
+#ifdef MICROBIT_HOST
+
+inline void benchmark_timer_init()
+{
+}
+
+inline uint32_t benchmark_cycles()
+{
+    return (uint32_t) host_cycles();
+}
+
+inline uint32_t benchmark_elapsed(uint32_t start, uint32_t end)
+{
+    return end - start;
+}
+
+#else
+
+/**
+  * Configures SysTick as a free running down counter at the core clock frequency, with no interrupt.
+  */
+inline void benchmark_timer_init()
+{
+    SysTick->LOAD = 0x00FFFFFF;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+inline uint32_t benchmark_cycles()
+{
+    return 0x00FFFFFF - SysTick->VAL;
+}
+
+inline uint32_t benchmark_elapsed(uint32_t start, uint32_t end)
+{
+    return (end - start) & 0x00FFFFFF;
+}
+
+#endif
+
+/**
+  * Initialises the cycle counter, and measures its own overhead.
+  * Must be called before any other benchmark function.
+  */
+void benchmark_init();
+
+/**
+  * Resets the given benchmark result, ready to record a new benchmark.
+  *
+  * @param result The result to reset.
+  * @param name The name of the benchmark.
+  */
+void benchmark_reset(BenchmarkResult &result, const char *name);
+
+/**
+  * Records a single operation.
+  *
+  * @param result The benchmark to record against.
+  * @param start The value of benchmark_cycles() at the start of the operation.
+  * @param end The value of benchmark_cycles() at the end of the operation.
+  */
+void benchmark_record(BenchmarkResult &result, uint32_t start, uint32_t end);
+
+/**
+  * Prints the header of a table of benchmark results over serial.
+  */
+void benchmark_print_header();
+
+/**
+  * Prints the given benchmark result over serial.
+  */
+void benchmark_print(BenchmarkResult &result);
+
+/**
+  * Ends the benchmark run. On the host this terminates the simulation, otherwise it simply
+  * displays a tick on the LED matrix.
+  */
+void benchmark_complete();
+
+#endif
@@ -0,0 +1,545 @@
+/**
+  * Micro-benchmarks for the fiber scheduler.
+  *
+  * Measures the cost of the most performance critical paths of MicroBitFiber.cpp:
+  *
+  * - context switch: cycles for schedule() to switch between two runnable fibers, and the number of
+  *   stack bytes paged out and in per switch, as the stack depth at the point of the switch grows.
+  *   The "dedicated" variants use fibers with a dedicated stack, which is not paged.
+  * - invoke: cycles for invoke() to run a handler that does not block.
+  * - fork on block: cycles for invoke() to return to its caller when the handler blocks, and the number of
+  *   stack bytes saved into the forked fiber.
+  * - queue_fiber: cycles to add a fiber to a queue already holding a number of fibers.
+  * - scheduler_tick: cycles spent in the system tick handler checking a sleep queue holding a number of fibers.
+  * - notify: cycles for scheduler_event() to wake one of a number of fibers, each waiting on a different event.
+  * - fiber_pool_trim: cycles for fiber_pool_trim() to release the fibers left in the fiber pool by a burst of
+  *   fork on block handlers, and the number of bytes released. The "allocs" column counts the fibers released.
+  * - sleepers (host only): the longest period interrupts are held off while a number of fibers repeatedly
+  *   sleep, either with interrupts disabled ("irq-off") or by the system tick's interrupt handler ("isr").
+  * - idle (host only): interrupts taken while the processor is idle for a second. Compare scheduler-benchmark-tickless,
+  *   built with MICROBIT_TICKLESS_IDLE enabled.
+  *
+  * In all cases, the "allocs" column counts the stack buffers (re)allocated by verify_stack_size()
+  * as a measure of heap churn.
+  *
+  * See MicroBitBenchmark.h for details on how to run this on the host and on a micro:bit.
+  */
+
+#include "MicroBitBenchmark.h"
+
+// Event used to signal the completion of a benchmark running in other fibers.
+#define BENCHMARK_ID                    4000
+#define BENCHMARK_EVT_DONE              1
+
+#define SWITCH_ITERATIONS               1000
+#define INVOKE_ITERATIONS               1000
+#define FORK_ITERATIONS                 100
+#define QUEUE_ITERATIONS                1000
+
+// Number of fibers held on a queue, to represent a program with one fiber blocked per event listener.
+#define QUEUE_FIBERS                    24
+
+// Duration of the sleepers benchmark, in milliseconds.
+#define SLEEPERS_PERIOD                 2000
+
+// Scheduler state not exported through MicroBitFiber.h.
+extern Fiber *forkedFiber;
+extern Fiber *fiberPool;
+extern unsigned long ticks;
+
+/**
+  * Tracking of fiber stack buffers, to detect allocations made by verify_stack_size().
+  */
+struct StackBufferRecord
+{
+    Fiber       *fiber;
+    uint32_t    stack_bottom;
+};
+
+#define BENCHMARK_MAX_FIBERS            32
+
+static StackBufferRecord stackBuffers[BENCHMARK_MAX_FIBERS];
+static int stackBufferCount = 0;
+
+/**
+  * Records the stack buffer of the given fiber.
+  * @return 1 if the buffer has been allocated since the fiber was last seen, 0 otherwise.
+  */
+static uint32_t stack_track(Fiber *f)
+{
+    for (int i = 0; i < stackBufferCount; i++)
+    {
+        if (stackBuffers[i].fiber == f)
+        {
+            if (stackBuffers[i].stack_bottom == f->stack_bottom)
+                return 0;
+
+            stackBuffers[i].stack_bottom = f->stack_bottom;
+            return 1;
+        }
+    }
+
+    if (stackBufferCount < BENCHMARK_MAX_FIBERS)
+    {
+        stackBuffers[stackBufferCount].fiber = f;
+        stackBuffers[stackBufferCount].stack_bottom = f->stack_bottom;
+        stackBufferCount++;
+    }
+
+    return f->stack_bottom != 0 ? 1 : 0;
+}
+
+/**
+  * Records the stack buffers of all fibers currently known to exist, so that only new allocations are counted.
+  */
+static void stack_snapshot()
+{
+    stackBufferCount = 0;
+
+    for (Fiber *f = fiberPool; f != NULL; f = f->next)
+        stack_track(f);
+
+    stack_track(currentFiber);
+}
+
+/**
+  * Determines the number of stack bytes paged out or in when the given fiber is switched.
+  */
+static uint32_t paged_bytes(Fiber *f)
+{
+    if (f->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK)
+        return 0;
+
+    return f->tcb.stack_base - f->tcb.SP;
+}
+
+/**
+  * Calls the given function with approximately the given number of bytes of additional stack in use.
+  */
+static void __attribute__((noinline)) call_at_depth(int bytes, void (*fn)(void))
+{
+    volatile uint32_t frame[8];
+
+    frame[0] = bytes;
+
+    if (bytes > 0)
+        call_at_depth(bytes - sizeof(frame), fn);
+    else
+        fn();
+
+    frame[1] = frame[0];
+}
+
+/**
+  * Context switch.
+  * n.b. all state is held in static storage, as fiber stacks are paged in and out of the same memory.
+  */
+static BenchmarkResult switchResult;
+static Fiber *switchFiber[2];
+static int switchDepth;
+static int switchFibers;
+static volatile int switchRemaining;
+static uint32_t switchStart;
+
+static void switch_yield()
+{
+    Fiber *self = currentFiber;
+    Fiber *other = self == switchFiber[0] ? switchFiber[1] : switchFiber[0];
+
+    switchStart = benchmark_cycles();
+    schedule();
+    uint32_t end = benchmark_cycles();
+
+    // We've been switched in from the other fiber's switch_yield().
+    if (switchRemaining > 0)
+    {
+        benchmark_record(switchResult, switchStart, end);
+
+        switchResult.totalBytes += paged_bytes(other) + paged_bytes(self);
+        switchResult.allocations += stack_track(self) + stack_track(other);
+
+        switchRemaining--;
+    }
+}
+
+static void switch_fiber()
+{
+    while (switchRemaining > 0)
+        call_at_depth(switchDepth, switch_yield);
+
+    if (--switchFibers == 0)
+        MicroBitEvent(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+}
+
+static void benchmark_context_switch(const char *name, int depth, uint32_t flags = 0)
+{
+    benchmark_reset(switchResult, name);
+    stack_snapshot();
+
+    switchDepth = depth;
+    switchFibers = 2;
+    switchRemaining = SWITCH_ITERATIONS;
+
+    // Neither fiber runs until we block, so the two fibers have the processor to themselves.
+    switchFiber[0] = create_fiber(switch_fiber, release_fiber, flags);
+    switchFiber[1] = create_fiber(switch_fiber, release_fiber, flags);
+
+    fiber_wait_for_event(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+
+    benchmark_print(switchResult);
+}
+
+/**
+  * invoke(), when the handler does not block.
+  */
+static volatile int invokeCount = 0;
+
+static void nonblocking_handler()
+{
+    invokeCount++;
+}
+
+static void benchmark_invoke(const char *name)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+    stack_snapshot();
+
+    for (int i = 0; i < INVOKE_ITERATIONS; i++)
+    {
+        uint32_t start = benchmark_cycles();
+        invoke(nonblocking_handler);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+    }
+
+    benchmark_print(result);
+}
+
+/**
+  * invoke(), when the handler blocks and a fiber is forked.
+  */
+static int forkDepth;
+
+static void fork_block()
+{
+    fiber_sleep(0);
+}
+
+static void blocking_handler()
+{
+    call_at_depth(forkDepth, fork_block);
+}
+
+static void benchmark_fork_on_block(const char *name, int depth)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+    stack_snapshot();
+
+    forkDepth = depth;
+
+    for (int i = 0; i < FORK_ITERATIONS; i++)
+    {
+        uint32_t start = benchmark_cycles();
+        invoke(blocking_handler);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+
+        result.totalBytes += forkedFiber->tcb.stack_base - forkedFiber->tcb.SP;
+        result.allocations += stack_track(forkedFiber);
+
+        // Let the forked fiber run to completion, and return to the fiber pool.
+        uBit.sleep(2 * uBit.getTickPeriod());
+    }
+
+    benchmark_print(result);
+}
+
+/**
+  * queue_fiber(), onto a long queue.
+  * The fibers are never scheduled, so they are simply held on a private queue.
+  */
+static Fiber *benchmarkQueue = NULL;
+
+static void benchmark_queue(const char *name)
+{
+    BenchmarkResult result;
+    Fiber *f = NULL;
+
+    benchmark_reset(result, name);
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+    {
+        f = new Fiber();
+        memset(f, 0, sizeof(Fiber));
+        queue_fiber(f, &benchmarkQueue);
+    }
+
+    for (int i = 0; i < QUEUE_ITERATIONS; i++)
+    {
+        // Cycle the fibers through the queue, so each one is in turn added at the tail.
+        f = benchmarkQueue;
+        dequeue_fiber(f);
+
+        uint32_t start = benchmark_cycles();
+        queue_fiber(f, &benchmarkQueue);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+    }
+
+    while (benchmarkQueue != NULL)
+    {
+        f = benchmarkQueue;
+        dequeue_fiber(f);
+        delete f;
+    }
+
+    benchmark_print(result);
+}
+
+/**
+  * scheduler_tick(), with many fibers sleeping but none due to wake up.
+  * The tick is called directly, with the clock wound back afterwards so no fiber ever falls due.
+  */
+static int tickSleepersRemaining;
+
+static void tick_sleeper(void *param)
+{
+    fiber_sleep((unsigned long)(uintptr_t) param);
+
+    if (--tickSleepersRemaining == 0)
+        MicroBitEvent(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+}
+
+static void benchmark_tick(const char *name)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+
+    tickSleepersRemaining = QUEUE_FIBERS;
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+        create_fiber(tick_sleeper, (void *)(uintptr_t)(500 + 10 * i));
+
+    // Let the fibers run, and go to sleep.
+    uBit.sleep(0);
+
+    for (int i = 0; i < QUEUE_ITERATIONS; i++)
+    {
+        __disable_irq();
+        unsigned long now = ticks;
+
+        uint32_t start = benchmark_cycles();
+        scheduler_tick();
+        uint32_t end = benchmark_cycles();
+
+        ticks = now;
+        __enable_irq();
+
+        benchmark_record(result, start, end);
+    }
+
+    fiber_wait_for_event(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+
+    benchmark_print(result);
+}
+
+/**
+  * scheduler_event(), waking one of many fibers blocked in fiber_wait_for_event().
+  * Each fiber waits on its own value of the NOTIFY channel.
+  */
+static volatile int notifyComplete;
+static int notifyWaitersRemaining;
+
+static void notify_waiter(void *param)
+{
+    uint16_t value = (uint16_t)(uintptr_t) param;
+
+    while (!notifyComplete)
+        fiber_wait_for_event(MICROBIT_ID_NOTIFY, value);
+
+    if (--notifyWaitersRemaining == 0)
+        MicroBitEvent(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+}
+
+static void benchmark_notify(const char *name)
+{
+    BenchmarkResult result;
+
+    benchmark_reset(result, name);
+
+    notifyComplete = 0;
+    notifyWaitersRemaining = QUEUE_FIBERS;
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+        create_fiber(notify_waiter, (void *)(uintptr_t)(BENCHMARK_ID + i));
+
+    // Let the fibers run, and block.
+    uBit.sleep(0);
+
+    for (int i = 0; i < QUEUE_ITERATIONS; i++)
+    {
+        MicroBitEvent evt(MICROBIT_ID_NOTIFY, BENCHMARK_ID + (i % QUEUE_FIBERS), CREATE_ONLY);
+
+        uint32_t start = benchmark_cycles();
+        scheduler_event(evt);
+        uint32_t end = benchmark_cycles();
+
+        benchmark_record(result, start, end);
+
+        // Let the woken fiber run, and block again.
+        schedule();
+    }
+
+    notifyComplete = 1;
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+        MicroBitEvent(MICROBIT_ID_NOTIFY, BENCHMARK_ID + i);
+
+    fiber_wait_for_event(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+
+    benchmark_print(result);
+}
+
+/**
+  * fiber_pool_trim(), after a burst of fork on block handlers that have all completed.
+  */
+static void benchmark_pool_trim(const char *name)
+{
+    BenchmarkResult result;
+    FiberPoolStatistics before, after;
+
+    benchmark_reset(result, name);
+
+    forkDepth = 256;
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+        invoke(blocking_handler);
+
+    // Let the forked fibers run to completion, and return to the fiber pool.
+    uBit.sleep(2 * uBit.getTickPeriod());
+
+    fiber_pool_statistics(&before);
+
+    uint32_t start = benchmark_cycles();
+    int released = fiber_pool_trim();
+    uint32_t end = benchmark_cycles();
+
+    fiber_pool_statistics(&after);
+
+    benchmark_record(result, start, end);
+    result.totalBytes = released;
+    result.allocations = before.pooled - after.pooled;
+
+    benchmark_print(result);
+}
+
+#ifdef MICROBIT_HOST
+
+/**
+  * Interrupt latency, with many fibers sleeping.
+  * Each fiber sleeps for a different period, so wake ups are spread across system ticks.
+  */
+static int sleepersRemaining;
+
+static void sleeper(void *param)
+{
+    unsigned long period = (unsigned long)(uintptr_t) param;
+    unsigned long end = uBit.systemTime() + SLEEPERS_PERIOD;
+
+    while (uBit.systemTime() < end)
+        fiber_sleep(period);
+
+    if (--sleepersRemaining == 0)
+        MicroBitEvent(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+}
+
+static void benchmark_sleepers(const char *irqName, const char *isrName)
+{
+    BenchmarkResult result;
+    HostIrqStatistics stats;
+
+    sleepersRemaining = QUEUE_FIBERS;
+
+    for (int i = 0; i < QUEUE_FIBERS; i++)
+        create_fiber(sleeper, (void *)(uintptr_t)(20 + 7 * i));
+
+    host_irq_statistics_reset();
+    fiber_wait_for_event(BENCHMARK_ID, BENCHMARK_EVT_DONE);
+    host_irq_statistics(&stats);
+
+    benchmark_reset(result, irqName);
+    result.count = stats.disableCount;
+    result.totalCycles = stats.totalCycles;
+    result.minCycles = 0;
+    result.maxCycles = stats.maxCycles;
+    benchmark_print(result);
+
+    benchmark_reset(result, isrName);
+    result.count = stats.isrCount;
+    result.totalCycles = stats.isrTotalCycles;
+    result.minCycles = 0;
+    result.maxCycles = stats.isrMaxCycles;
+    benchmark_print(result);
+}
+
+/**
+  * Interrupts taken while the processor is idle for a second, with a single fiber sleeping.
+  * The count shows how many times the processor was woken up.
+  */
+static void benchmark_idle(const char *name)
+{
+    BenchmarkResult result;
+    HostIrqStatistics stats;
+
+    host_irq_statistics_reset();
+    uBit.sleep(1000);
+    host_irq_statistics(&stats);
+
+    benchmark_reset(result, name);
+    result.count = stats.isrCount;
+    result.totalCycles = stats.isrTotalCycles;
+    result.minCycles = 0;
+    result.maxCycles = stats.isrMaxCycles;
+    benchmark_print(result);
+}
+
+#endif
+
+void app_main()
+{
+    benchmark_init();
+
+    uBit.serial.printf("micro:bit runtime %s: scheduler benchmarks\n", uBit.systemVersion());
+    benchmark_print_header();
+
+    benchmark_context_switch("context switch/0", 0);
+    benchmark_context_switch("context switch/256", 256);
+    benchmark_context_switch("context switch/1024", 1024);
+    benchmark_context_switch("context switch/dedicated/0", 0, MICROBIT_FIBER_FLAG_DEDICATED_STACK);
+    benchmark_context_switch("context switch/dedicated/1024", 1024, MICROBIT_FIBER_FLAG_DEDICATED_STACK);
+
+    benchmark_invoke("invoke/non-blocking");
+
+    benchmark_fork_on_block("invoke/blocking/0", 0);
+    benchmark_fork_on_block("invoke/blocking/256", 256);
+
+    benchmark_queue("queue_fiber/24");
+    benchmark_tick("scheduler_tick/24");
+    benchmark_notify("notify/24");
+    benchmark_pool_trim("fiber_pool_trim/24");
+
+#ifdef MICROBIT_HOST
+    benchmark_sleepers("sleepers/24 irq-off", "sleepers/24 isr");
+    benchmark_idle("idle/1s isr");
+#endif
+
+    benchmark_complete();
+}
@@ -0,0 +1,30 @@
+/**
+  * A simple program for the host build of the micro:bit runtime.
+  *
+  * Sends a datagram over the (loopback) radio, scrolls some text on the display and reports
+  * progress over serial, then ends the simulation.
+  */
+
+#include "MicroBit.h"
+
+void onData(MicroBitEvent)
+{
+    ManagedString s = uBit.radio.datagram.recv();
+
+    uBit.serial.printf("received \"%s\" at %lu ms\n", s.toCharArray(), uBit.systemTime());
+}
+
+void app_main()
+{
+    uBit.serial.printf("hello, world from micro:bit runtime %s\n", uBit.systemVersion());
+
+    uBit.MessageBus.listen(MICROBIT_ID_RADIO, MICROBIT_RADIO_EVT_DATAGRAM, onData);
+    uBit.radio.enable();
+    uBit.radio.datagram.send("ping");
+
+    uBit.display.scroll("HELLO");
+
+    uBit.serial.printf("scrolled text by %lu ms\n", uBit.systemTime());
+
+    host_exit(0);
+}
@@ -0,0 +1,281 @@
+#ifndef MICROBIT_H
+#define MICROBIT_H
+
+/**
+  * Host (Linux) variant of MicroBit.h.
+  *
+  * Takes the place of inc/MicroBit.h in host builds. The device singleton is reduced to the components
+  * that can be meaningfully simulated (display, serial, I2C, radio, message bus and scheduler), but retains
+  * the same member names and system tick / idle component machinery as the real device, so runtime
+  * code referring to uBit compiles and behaves unmodified.
+  */
+
+#include "mbed.h"
+
+#include "MicroBitConfig.h"
+#include "MicroBitHeapAllocator.h"
+#include "MicroBitPanic.h"
+#include "MicroBitTrace.h"
+#include "ErrorNo.h"
+#include "MicroBitCompat.h"
+#include "MicroBitComponent.h"
+#include "ManagedType.h"
+#include "ManagedString.h"
+#include "MicroBitImage.h"
+#include "MicroBitFont.h"
+#include "MicroBitEvent.h"
+#include "MicroBitI2C.h"
+#include "MESEvents.h"
+
+#include "MicroBitLightSensor.h"
+#include "MicroBitSerial.h"
+#include "MicroBitDisplay.h"
+
+#include "MicroBitFiber.h"
+#include "MicroBitMessageBus.h"
+
+#include "MicroBitRadio.h"
+
+#include "MicroBitHost.h"
+
+// MicroBit::flags values
+#define MICROBIT_FLAG_SCHEDULER_RUNNING         0x00000001
+#define MICROBIT_FLAG_ACCELEROMETER_RUNNING     0x00000002
+#define MICROBIT_FLAG_DISPLAY_RUNNING           0x00000004
+#define MICROBIT_FLAG_COMPASS_RUNNING           0x00000008
+#define MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED     0x00000010
+
+// mbed pin assignments of core components.
+#define MICROBIT_PIN_SDA                        P0_30
+#define MICROBIT_PIN_SCL                        P0_0
+#define MICROBIT_PIN_BUTTON_RESET               P0_19
+
+#define MICROBIT_DEFAULT_TICK_PERIOD            FIBER_TICK_PERIOD_MS
+
+// Transmit power levels, normally provided by MicroBitBLEManager.
+#define MICROBIT_BLE_POWER_LEVELS               8
+extern const int8_t MICROBIT_BLE_POWER_LEVEL[];
+
+/**
+  * There is no BLE stack on the host. uBit.ble is therefore always NULL.
+  */
+class BLEDevice
+{
+    public:
+
+    void waitForEvent()
+    {
+        __WFI();
+    }
+};
+
+/**
+  * Class definition for a simulated MicroBit device.
+  */
+class MicroBit
+{
+    private:
+
+    //the current tick period in MS
+    int                     tickPeriod;
+
+    // State of the system tick, used to keep the system time accurate when the tick is suspended (tickless idle).
+    uint32_t                tickStartedAt;      // The time the periodic system tick was last started (microseconds).
+    uint32_t                tickLag;            // How far the system time lagged behind real time at that point (microseconds).
+    uint32_t                tickSuspendedAt;    // The time at which the system time was exact, when the system tick was suspended.
+
+    /**
+      * Starts the periodic system tick.
+      * @param lag How far the system time lags behind real time, in microseconds.
+      */
+    void startSystemTick(uint32_t lag);
+
+    /**
+      * Determines how far the system time currently lags behind real time (as it is only updated once per tick).
+      * @return The lag, in microseconds.
+      */
+    uint32_t systemTickLag();
+
+    /**
+      * Ends a suspension of the system tick, from the single tick scheduled in its place.
+      * Advances the system time by the tick periods that have elapsed since the tick was suspended
+      * (less the current one, which scheduler_tick() accounts for), and restarts the periodic system tick.
+      */
+    void restartSystemTick();
+
+    // Current state of the random number generator.
+    uint32_t                randomValue;
+
+    public:
+
+    // Map of device state.
+    uint32_t                flags;
+
+    // Periodic callback
+    Ticker                  systemTicker;
+
+    // I2C Interface
+    MicroBitI2C             i2c;
+
+    // Serial Interface
+    MicroBitSerial          serial;
+
+    // Array of components which are iterated during a system tick
+    MicroBitComponent*      systemTickComponents[MICROBIT_SYSTEM_COMPONENTS];
+
+    // Array of components which are iterated during idle thread execution, isIdleCallbackNeeded is polled during a systemTick.
+    MicroBitComponent*      idleThreadComponents[MICROBIT_IDLE_COMPONENTS];
+
+    // Device level Message Bus abstraction
+    MicroBitMessageBus      MessageBus;
+
+    // Member variables to represent each of the simulated components on the device.
+    MicroBitDisplay         display;
+    MicroBitRadio           radio;
+    BLEDevice               *ble;
+
+    /**
+      * Constructor.
+      * Create a representation of a simulated MicroBit device as a global singleton.
+      */
+    MicroBit();
+
+    /**
+      * Post constructor initialisation method.
+      * Registers the system components, and starts the system ticker.
+      */
+    void init();
+
+    /**
+      * Terminates the simulation.
+      */
+    void reset();
+
+    /**
+      * Delay for the given amount of time.
+      * If the scheduler is running, this will deschedule the current fiber and perform
+      * a power efficent, concurrent sleep operation.
+      * If the scheduler is disabled or we're running in an interrupt context, this
+      * will revert to a busy wait.
+      *
+      * @param milliseconds the amount of time, in ms, to wait for. This number cannot be negative.
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER milliseconds is less than zero.
+      */
+    int sleep(int milliseconds);
+
+    /**
+      * Generate a random number in the given range, using the same Galois LFSR as the device.
+      * @param max the upper range to generate a number for. This number cannot be negative
+      * @return A random, natural number between 0 and the max-1. Or MICROBIT_INVALID_PARAMETER if max is <= 0.
+      */
+    int random(int max);
+
+    /**
+      * Seed the random number generator. There is no hardware RNG on the host, so a fixed seed is
+      * used to keep runs deterministic.
+      */
+    void seedRandom();
+
+    /**
+      * Seed the pseudo random number generator using the given 32-bit value.
+      * @param seed The value to use as a seed.
+      */
+    void seedRandom(uint32_t seed);
+
+    /**
+      * Periodic callback. Used by MicroBitDisplay, FiberScheduler and I2C sensors to
+      * provide a power efficient sense of time.
+      */
+    void systemTick();
+
+    /**
+      * System tasks to be executed by the idle thread when the Micro:Bit isn't busy or when data needs to be read.
+      */
+    void systemTasks();
+
+    /**
+      * add a component to the array of system components which invocate the systemTick member function during a systemTick
+      *
+      * @param component The component to add.
+      * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+      */
+    int addSystemComponent(MicroBitComponent *component);
+
+    /**
+      * remove a component from the array of system components
+      * @param component The component to remove.
+      * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMETER is returned if the given component has not been previous added.
+      */
+    int removeSystemComponent(MicroBitComponent *component);
+
+    /**
+      * add a component to the array of of idle thread components.
+      * isIdleCallbackNeeded is polled during a systemTick to determine if the idle thread should jump to the front of the queue
+      * @param component The component to add.
+      * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+      */
+    int addIdleComponent(MicroBitComponent *component);
+
+    /**
+      * remove a component from the array of idle thread components
+      * @param component The component to remove.
+      * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMETER is returned if the given component has not been previous added.
+      */
+    int removeIdleComponent(MicroBitComponent *component);
+
+    /**
+      * Suspends the periodic system tick while the processor is idle, if nothing needs it for a while (tickless idle).
+      * A single system tick is instead scheduled for when a sleeping fiber is next due to be woken up, or a component
+      * next needs a tick (see MicroBitComponent::systemTickPeriod()), whichever is sooner.
+      * Called by the idle task just before the processor sleeps, and followed by resumeSystemTick() when it wakes.
+      *
+      * @return MICROBIT_OK if the system tick was suspended, or MICROBIT_BUSY if a tick is needed within the next two tick periods anyway.
+      */
+    int suspendSystemTick();
+
+    /**
+      * Brings the system time up to date after suspendSystemTick(), once the processor wakes up, and brings
+      * the scheduled system tick forward to the next tick period boundary. That tick restarts the periodic system tick.
+      * Does nothing if the system tick is not suspended.
+      */
+    void resumeSystemTick();
+
+    /*
+     * Reconfigures the ticker to the given speed in milliseconds.
+     * @param speedMs the speed in milliseconds
+     * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMETER is returned if speedUs < 1
+     */
+    int setTickPeriod(int speedMs);
+
+    /*
+     * Returns the currently used tick speed in milliseconds
+     */
+    int getTickPeriod();
+
+    /**
+      * Determine the time since this MicroBit was last reset.
+      * @return The time since the last reset, in milliseconds.
+      */
+    unsigned long systemTime();
+
+    /**
+      * Determine the version of the micro:bit runtime currently in use.
+      * @return A textual description of the currentlt executing micro:bit runtime.
+      */
+    const char *systemVersion();
+
+    /**
+      * Reports the given panic code on stderr, and terminates the simulation with that code as the exit status.
+      * @param statusCode the status code of the associated error.
+      */
+    void panic(int statusCode = 0);
+};
+
+// Definition of the global instance of the MicroBit class.
+extern MicroBit uBit;
+
+// Entry point for application programs. Called after the super-main function
+// has initialized the device and runtime environment.
+extern "C" void app_main();
+
+#endif
@@ -0,0 +1,117 @@
+/**
+  * Control interface for the host (Linux) simulation of the micro:bit runtime.
+  *
+  * Programs built against the host target are normal micro:bit programs: they implement app_main(),
+  * and are started by a super-main that brings up the heap, fiber scheduler and uBit just as on the device.
+  * The functions below give such programs (typically benchmarks) control over the simulated hardware.
+  *
+  * Memory layout follows the device: simulated SRAM is mapped at MICROBIT_SRAM_BASE, with the SoftDevice
+  * region at the bottom, followed by the native (mbed) heap and the system stack at the top. Sizes are set
+  * in MicroBitHostConfig.h.
+  */
+
+#ifndef MICROBIT_HOST_H
+#define MICROBIT_HOST_H
+
+#include "mbed.h"
+
+/**
+  * Statistics on the time interrupts have been held off, either through __disable_irq(), or by
+  * another interrupt service routine running.
+  */
+struct HostIrqStatistics
+{
+    uint32_t    disableCount;       // The number of times interrupts have been disabled.
+    uint64_t    totalCycles;        // The total number of host cycles spent with interrupts disabled.
+    uint64_t    maxCycles;          // The longest single period spent with interrupts disabled, in host cycles.
+    uint32_t    isrCount;           // The number of times pending interrupts have been serviced.
+    uint64_t    isrTotalCycles;     // The total number of host cycles spent in interrupt context.
+    uint64_t    isrMaxCycles;       // The longest single period spent in interrupt context, in host cycles.
+};
+
+/**
+  * Determine the number of microseconds of virtual time since power on.
+  */
+uint64_t host_time_us();
+
+/**
+  * Advance the virtual clock by the given number of microseconds.
+  * Any timers that fall due are fired in interrupt context, in deadline order.
+  *
+  * @param us The number of microseconds to advance.
+  */
+void host_advance_us(uint64_t us);
+
+/**
+  * Simulates a processor sleep: advances the virtual clock to the next interrupt, and services it.
+  */
+void host_wait_for_interrupt();
+
+/**
+  * Reads a free running host cycle counter. Used for benchmarking only: unlike virtual time,
+  * this is a measure of real time spent on the host, and is not deterministic.
+  */
+uint64_t host_cycles();
+
+/**
+  * Reads the statistics on interrupt disabled time recorded since power on, or since the last reset.
+  * @param stats The structure to populate.
+  */
+void host_irq_statistics(HostIrqStatistics *stats);
+
+/**
+  * Clears all interrupt disabled statistics.
+  */
+void host_irq_statistics_reset();
+
+/**
+  * Reads the level of the given pin, as driven by the simulated device.
+  * @param pin The pin to read.
+  * @return 1 if the pin is driven high, 0 otherwise.
+  */
+int host_gpio_read(PinName pin);
+
+/**
+  * Drives the given input pin to the given level, as if from an external source.
+  * Any InterruptIn attached to the pin is fired in interrupt context.
+  *
+  * @param pin The pin to drive.
+  * @param value The level to drive the pin to (0 or 1).
+  */
+void host_gpio_write(PinName pin, int value);
+
+/**
+  * Sets the value returned by an AnalogIn on the given pin.
+  * @param pin The pin to configure.
+  * @param value The 16 bit sample value.
+  */
+void host_analog_write(PinName pin, uint16_t value);
+
+/**
+  * Attaches a memory backed device to the simulated I2C bus.
+  *
+  * The device behaves as a typical register based sensor: the first byte of a write sets the register
+  * address, and subsequent bytes written or read auto-increment that address.
+  *
+  * @param address The 8 bit I2C address of the device.
+  * @param registers The memory used to store the device registers.
+  * @param length The number of registers available.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if no registers are given, or MICROBIT_NO_RESOURCES
+  * if no more devices can be attached.
+  */
+int host_i2c_attach(int address, uint8_t *registers, int length);
+
+/**
+  * Makes the given characters available for reading on the simulated serial port.
+  * @param data The data to make available.
+  * @param length The number of bytes of data.
+  */
+void host_serial_feed(const char *data, int length);
+
+/**
+  * Terminates the simulation.
+  * @param status The exit status of the host process.
+  */
+void host_exit(int status) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,41 @@
+/**
+  * Compile time configuration of the micro:bit runtime for host (Linux) builds.
+  *
+  * This file is force-included ahead of every translation unit in the host build, in the same way as
+  * a yotta supplied configuration file, so anything defined here overrides the defaults in MicroBitConfig.h.
+  */
+
+#ifndef MICROBIT_HOST_CONFIG_H
+#define MICROBIT_HOST_CONFIG_H
+
+// Identifies a host build, for code that needs to behave differently under simulation (e.g. benchmarks).
+#define MICROBIT_HOST                   1
+
+// Physical address of the base of simulated SRAM. This matches the nrf51822, so the
+// fixed addresses used by the SoftDevice heap are valid on the host too.
+#define MICROBIT_SRAM_BASE              0x20000000
+
+// The simulated SRAM is larger than that of the device, as host stack frames are
+// substantially larger than those of a Cortex M0.
+#define MICROBIT_SRAM_END               0x20040000
+
+// Top of the system stack. Offset by one word from the end of SRAM, so that the initial stack pointer given
+// to new fibers (CORTEX_M0_STACK_BASE - 4) meets the 16 byte alignment required by the x86-64 ABI.
+#define CORTEX_M0_STACK_BASE            (MICROBIT_SRAM_END - 0x04)
+
+#define MICROBIT_STACK_SIZE             65536
+
+// Dedicated fiber stacks are scaled up in the same way.
+#define FIBER_DEDICATED_STACK_SIZE      16384
+
+// There's no SoftDevice on the host, so the whole of its region is reused as heap.
+#define MICROBIT_BLE_ENABLED            0
+#define MICROBIT_BLE_PAIRING_MODE       0
+
+// The C library heap lies outside simulated SRAM, so the host provides the native heap used to host
+// the nested micro:bit heap (see HostHAL.cpp).
+#define MICROBIT_HEAP_NATIVE_EXTERNAL
+
+#define MICROBIT_DAL_VERSION            "host"
+
+#endif
@@ -0,0 +1,458 @@
+/**
+  * Simulated mbed-classic HAL for host (Linux) builds of the micro:bit runtime.
+  *
+  * This header stands in for the real mbed.h when the runtime is compiled with the
+  * host build target (see host/CMakeLists.txt). It provides just enough of the mbed API
+  * used by the runtime to allow the core of the DAL (fiber scheduler, message bus,
+  * heap allocator, managed types and display driver) to run unmodified on a Linux box:
+  *
+  * 1) Ticker and Timeout are driven by a virtual clock. Time only advances when the simulated
+  *    processor sleeps (__WFI), busy waits (wait_us() etc.) or the host explicitly advances it,
+  *    so every run of a program is deterministic.
+  * 2) GPIO is modelled as a set of 32 bit port registers (c.f. nrf_gpio.h).
+  * 3) I2C transfers are served from memory backed register maps attached by the host.
+  * 4) Serial output is written to stdout, and input is read from a buffer fed by the host.
+  *
+  * Interrupts are simulated by calling the relevant handler from "interrupt context" whenever the
+  * virtual clock advances. __disable_irq() / __enable_irq() defer those handlers exactly as the NVIC would,
+  * and also record how long interrupts were held off, measured in host cycles.
+  *
+  * See MicroBitHost.h for the API used to control the simulation.
+  */
+
+#ifndef MBED_H
+#define MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <sys/types.h>
+
+#include "nrf51.h"
+
+typedef uint32_t timestamp_t;
+
+/**
+  * Pin names of the nrf51822.
+  */
+typedef enum {
+    P0_0 = 0, P0_1, P0_2, P0_3, P0_4, P0_5, P0_6, P0_7,
+    P0_8, P0_9, P0_10, P0_11, P0_12, P0_13, P0_14, P0_15,
+    P0_16, P0_17, P0_18, P0_19, P0_20, P0_21, P0_22, P0_23,
+    P0_24, P0_25, P0_26, P0_27, P0_28, P0_29, P0_30, P0_31,
+
+    USBTX = P0_24,
+    USBRX = P0_25,
+
+    NC = (int)0xFFFFFFFF
+} PinName;
+
+typedef enum {
+    PullNone = 0,
+    PullDown = 1,
+    PullUp = 3,
+    PullDefault = PullUp
+} PinMode;
+
+/**
+  * Simulated processor state. Defined in HostHAL.cpp.
+  */
+extern volatile uint32_t host_ipsr;
+
+void host_irq_disable();
+void host_irq_enable();
+uint32_t host_irq_disabled();
+void host_service_timers();
+void host_wait_for_interrupt();
+void host_advance_us(uint64_t us);
+uint64_t host_time_us();
+
+inline void __disable_irq()
+{
+    host_irq_disable();
+}
+
+inline void __enable_irq()
+{
+    host_irq_enable();
+}
+
+inline uint32_t __get_IPSR()
+{
+    return host_ipsr;
+}
+
+/**
+  * Reads the interrupt mask: 1 if interrupts are disabled, 0 otherwise.
+  */
+inline uint32_t __get_PRIMASK()
+{
+    return host_irq_disabled();
+}
+
+/**
+  * Restores an interrupt mask read by __get_PRIMASK().
+  */
+inline void __set_PRIMASK(uint32_t primask)
+{
+    if (primask)
+        host_irq_disable();
+    else
+        host_irq_enable();
+}
+
+/**
+  * Returns the current stack pointer. The host build maps the simulated SRAM (and hence the
+  * system stack) into the bottom 4GB of the address space, so this always fits in 32 bits.
+  */
+inline uint32_t __attribute__((always_inline)) __get_MSP()
+{
+    uint64_t sp;
+    __asm__ volatile ("mov %%rsp, %0" : "=r" (sp));
+    return (uint32_t) sp;
+}
+
+/**
+  * Reads the microsecond ticker that drives Ticker and Timeout (the virtual clock).
+  */
+inline uint32_t us_ticker_read()
+{
+    return (uint32_t) host_time_us();
+}
+
+inline void __WFI()
+{
+    host_wait_for_interrupt();
+}
+
+inline void wait_us(int us)
+{
+    host_advance_us(us);
+}
+
+inline void wait_ms(int ms)
+{
+    host_advance_us((uint64_t)ms * 1000);
+}
+
+inline void wait(float s)
+{
+    host_advance_us((uint64_t)(s * 1000000.0f));
+}
+
+namespace mbed {
+
+/**
+  * Holds a reference to a C function, or to a method on a C++ object,
+  * in the same style as mbed's FunctionPointer.
+  */
+class FunctionPointer
+{
+    void *object;
+    uint32_t method[4];
+    void (*function)();
+    void (*invoke)(void *object, uint32_t *method);
+
+    template <typename T>
+    static void methodCall(void *object, uint32_t *method)
+    {
+        T* o = (T*)object;
+        void (T::*m)(void);
+        memcpy(&m, method, sizeof(m));
+
+        (o->*m)();
+    }
+
+    public:
+
+    FunctionPointer()
+    {
+        object = NULL;
+        function = NULL;
+        invoke = NULL;
+    }
+
+    void attach(void (*fptr)(void))
+    {
+        object = NULL;
+        function = fptr;
+        invoke = NULL;
+    }
+
+    template <typename T>
+    void attach(T *o, void (T::*m)(void))
+    {
+        object = o;
+        function = NULL;
+        memset(method, 0, sizeof(method));
+        memcpy(method, &m, sizeof(m));
+        invoke = &FunctionPointer::methodCall<T>;
+    }
+
+    void call()
+    {
+        if (invoke)
+            invoke(object, method);
+        else if (function)
+            function();
+    }
+
+    bool attached()
+    {
+        return invoke != NULL || function != NULL;
+    }
+};
+
+/**
+  * A timer event on the virtual clock.
+  * Used to implement Ticker (periodic) and Timeout (one shot).
+  */
+class TimerEvent
+{
+    friend void ::host_service_timers();
+
+    protected:
+
+    FunctionPointer handler;
+    uint64_t deadline;
+    uint64_t period;
+    bool active;
+    TimerEvent *next;
+
+    void insert(uint64_t t, uint64_t p);
+    void remove();
+
+    public:
+
+    TimerEvent();
+    virtual ~TimerEvent();
+
+    void detach()
+    {
+        remove();
+    }
+
+    uint64_t getDeadline()
+    {
+        return deadline;
+    }
+};
+
+class Ticker : public TimerEvent
+{
+    public:
+
+    void attach(void (*fptr)(void), float t)
+    {
+        attach_us(fptr, (timestamp_t)(t * 1000000.0f));
+    }
+
+    template <typename T>
+    void attach(T *o, void (T::*m)(void), float t)
+    {
+        attach_us(o, m, (timestamp_t)(t * 1000000.0f));
+    }
+
+    void attach_us(void (*fptr)(void), timestamp_t t)
+    {
+        handler.attach(fptr);
+        insert(host_time_us() + t, t);
+    }
+
+    template <typename T>
+    void attach_us(T *o, void (T::*m)(void), timestamp_t t)
+    {
+        handler.attach(o, m);
+        insert(host_time_us() + t, t);
+    }
+};
+
+class Timeout : public Ticker
+{
+    public:
+
+    void attach(void (*fptr)(void), float t)
+    {
+        attach_us(fptr, (timestamp_t)(t * 1000000.0f));
+    }
+
+    template <typename T>
+    void attach(T *o, void (T::*m)(void), float t)
+    {
+        attach_us(o, m, (timestamp_t)(t * 1000000.0f));
+    }
+
+    void attach_us(void (*fptr)(void), timestamp_t t)
+    {
+        handler.attach(fptr);
+        insert(host_time_us() + t, 0);
+    }
+
+    template <typename T>
+    void attach_us(T *o, void (T::*m)(void), timestamp_t t)
+    {
+        handler.attach(o, m);
+        insert(host_time_us() + t, 0);
+    }
+};
+
+class DigitalOut
+{
+    PinName pin;
+
+    public:
+
+    DigitalOut(PinName pin);
+    DigitalOut(PinName pin, int value);
+
+    void write(int value);
+    int read();
+
+    DigitalOut& operator= (int value)
+    {
+        write(value);
+        return *this;
+    }
+
+    operator int()
+    {
+        return read();
+    }
+};
+
+class DigitalIn
+{
+    PinName pin;
+
+    public:
+
+    DigitalIn(PinName pin);
+    DigitalIn(PinName pin, PinMode mode);
+
+    void mode(PinMode pull);
+    int read();
+
+    operator int()
+    {
+        return read();
+    }
+};
+
+class InterruptIn
+{
+    PinName pin;
+    FunctionPointer riseHandler;
+    FunctionPointer fallHandler;
+
+    public:
+
+    InterruptIn(PinName pin);
+    ~InterruptIn();
+
+    int read();
+    void mode(PinMode pull);
+
+    void rise(void (*fptr)(void))
+    {
+        riseHandler.attach(fptr);
+    }
+
+    template <typename T>
+    void rise(T *o, void (T::*m)(void))
+    {
+        riseHandler.attach(o, m);
+    }
+
+    void fall(void (*fptr)(void))
+    {
+        fallHandler.attach(fptr);
+    }
+
+    template <typename T>
+    void fall(T *o, void (T::*m)(void))
+    {
+        fallHandler.attach(o, m);
+    }
+
+    void edge(int value);
+
+    operator int()
+    {
+        return read();
+    }
+};
+
+class AnalogIn
+{
+    PinName pin;
+
+    public:
+
+    AnalogIn(PinName pin);
+
+    unsigned short read_u16();
+    float read();
+
+    operator float()
+    {
+        return read();
+    }
+};
+
+/**
+  * Internal state of an I2C peripheral, mirroring the nrf51822 mbed port.
+  */
+struct i2c_t
+{
+    NRF_TWI_Type *i2c;
+};
+
+class I2C
+{
+    protected:
+
+    i2c_t _i2c;
+    int _hz;
+
+    public:
+
+    I2C(PinName sda, PinName scl);
+
+    void frequency(int hz);
+    int read(int address, char *data, int length, bool repeated = false);
+    int write(int address, const char *data, int length, bool repeated = false);
+};
+
+class Serial
+{
+    protected:
+
+    int _baud;
+
+    public:
+
+    Serial(PinName tx, PinName rx, const char *name = NULL);
+    virtual ~Serial();
+
+    void baud(int baudrate);
+    int readable();
+    int writeable();
+
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    int putc(int c);
+    int getc();
+    ssize_t write(const void *buffer, size_t length);
+
+    virtual int _putc(int c);
+    virtual int _getc();
+};
+
+} // namespace mbed
+
+using namespace mbed;
+
+#endif
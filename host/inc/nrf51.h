@@ -0,0 +1,160 @@
+/**
+  * Simulated nrf51822 peripheral registers for host (Linux) builds of the micro:bit runtime.
+  *
+  * Only the registers and bitfields used by the runtime are modelled. Plain registers are simple
+  * memory locations. TASKS registers are modelled with a HostTaskRegister, which invokes the behaviour
+  * of the simulated peripheral when written, allowing the runtime's drivers to run unmodified.
+  *
+  * The RADIO peripheral is modelled as a loopback device: any packet transmitted is received again
+  * by the same device, and delivered through RADIO_IRQHandler once the radio is back in receive mode.
+  */
+
+#ifndef NRF51_H
+#define NRF51_H
+
+#include <stdint.h>
+
+typedef enum {
+    POWER_CLOCK_IRQn = 0,
+    RADIO_IRQn = 1,
+    UART0_IRQn = 2,
+    SPI0_TWI0_IRQn = 3,
+    SPI1_TWI1_IRQn = 4,
+    GPIOTE_IRQn = 6,
+    ADC_IRQn = 7,
+    TIMER0_IRQn = 8,
+    RTC1_IRQn = 17
+} IRQn_Type;
+
+/**
+  * A TASKS register. Writing a non-zero value triggers the given task in the simulated peripheral.
+  */
+struct HostTaskRegister
+{
+    void (*task)();
+
+    HostTaskRegister(void (*task)()) : task(task) {}
+
+    HostTaskRegister& operator= (uint32_t value)
+    {
+        if (value && task)
+            task();
+
+        return *this;
+    }
+};
+
+/**
+  * An EVENTS register. Simulated peripherals mark an event as pending when an operation is started, and
+  * the event is raised the next time the register is polled. This models hardware that completes
+  * asynchronously, while software is busy waiting on the event.
+  */
+struct HostEventRegister
+{
+    uint32_t value;
+    bool pending;
+
+    HostEventRegister() : value(0), pending(false) {}
+
+    HostEventRegister& operator= (uint32_t v)
+    {
+        value = v;
+        return *this;
+    }
+
+    operator uint32_t()
+    {
+        if (value == 0 && pending)
+        {
+            value = 1;
+            pending = false;
+        }
+
+        return value;
+    }
+};
+
+typedef struct {
+    HostTaskRegister TASKS_TXEN;
+    HostTaskRegister TASKS_RXEN;
+    HostTaskRegister TASKS_START;
+    HostTaskRegister TASKS_DISABLE;
+    HostEventRegister EVENTS_READY;
+    HostEventRegister EVENTS_END;
+    HostEventRegister EVENTS_DISABLED;
+    volatile uint32_t INTENSET;
+    volatile uint32_t CRCSTATUS;
+    volatile uint32_t PACKETPTR;
+    volatile uint32_t FREQUENCY;
+    volatile uint32_t TXPOWER;
+    volatile uint32_t MODE;
+    volatile uint32_t PCNF0;
+    volatile uint32_t PCNF1;
+    volatile uint32_t BASE0;
+    volatile uint32_t PREFIX0;
+    volatile uint32_t TXADDRESS;
+    volatile uint32_t RXADDRESSES;
+    volatile uint32_t CRCCNF;
+    volatile uint32_t CRCPOLY;
+    volatile uint32_t CRCINIT;
+    volatile uint32_t DATAWHITEIV;
+} NRF_RADIO_Type;
+
+typedef struct {
+    HostTaskRegister TASKS_HFCLKSTART;
+    HostEventRegister EVENTS_HFCLKSTARTED;
+} NRF_CLOCK_Type;
+
+typedef struct {
+    volatile uint32_t ENABLE;
+    volatile uint32_t CONFIG;
+    volatile uint32_t RESULT;
+} NRF_ADC_Type;
+
+typedef struct {
+    volatile uint32_t EVENTS_ERROR;
+    volatile uint32_t ENABLE;
+    volatile uint32_t POWER;
+} NRF_TWI_Type;
+
+extern NRF_RADIO_Type host_radio;
+extern NRF_CLOCK_Type host_clock;
+extern NRF_ADC_Type host_adc;
+extern NRF_TWI_Type host_twi[2];
+
+#define NRF_RADIO                   (&host_radio)
+#define NRF_CLOCK                   (&host_clock)
+#define NRF_ADC                     (&host_adc)
+#define NRF_TWI0                    (&host_twi[0])
+#define NRF_TWI1                    (&host_twi[1])
+
+// RADIO bitfields.
+#define RADIO_MODE_MODE_Nrf_1Mbit                   (0x00UL)
+#define RADIO_CRCCNF_LEN_Two                        (0x02UL)
+
+// ADC bitfields.
+#define ADC_ENABLE_ENABLE_Disabled                  (0x00UL)
+#define ADC_ENABLE_ENABLE_Enabled                   (0x01UL)
+#define ADC_CONFIG_RES_Pos                          (0UL)
+#define ADC_CONFIG_RES_8bit                         (0x00UL)
+#define ADC_CONFIG_INPSEL_Pos                       (2UL)
+#define ADC_CONFIG_INPSEL_SupplyTwoThirdsPrescaling (0x06UL)
+#define ADC_CONFIG_REFSEL_Pos                       (5UL)
+#define ADC_CONFIG_REFSEL_VBG                       (0x00UL)
+#define ADC_CONFIG_PSEL_Pos                         (8UL)
+#define ADC_CONFIG_PSEL_Disabled                    (0UL)
+#define ADC_CONFIG_EXTREFSEL_Pos                    (16UL)
+#define ADC_CONFIG_EXTREFSEL_None                   (0UL)
+
+// TWI bitfields.
+#define TWI_ENABLE_ENABLE_Pos                       (0UL)
+#define TWI_ENABLE_ENABLE_Disabled                  (0x00UL)
+#define TWI_ENABLE_ENABLE_Enabled                   (0x05UL)
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_SystemReset(void);
+
+#endif
@@ -0,0 +1,15 @@
+/**
+  * Simulated nrf51822 busy wait delay for host (Linux) builds of the micro:bit runtime.
+  */
+
+#ifndef NRF_DELAY_H
+#define NRF_DELAY_H
+
+#include "mbed.h"
+
+inline void nrf_delay_us(uint32_t volatile number_of_us)
+{
+    wait_us(number_of_us);
+}
+
+#endif
@@ -0,0 +1,48 @@
+/**
+  * Simulated nrf51822 GPIO port access for host (Linux) builds of the micro:bit runtime.
+  *
+  * The 32 GPIO pins are modelled as three 32 bit registers (OUT, IN and DIR).
+  * As on the nrf51822, the pins may also be accessed as four 8 bit ports.
+  */
+
+#ifndef NRF_GPIO_H
+#define NRF_GPIO_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    NRF_GPIO_PORT_SELECT_PORT0 = 0,
+    NRF_GPIO_PORT_SELECT_PORT1,
+    NRF_GPIO_PORT_SELECT_PORT2,
+    NRF_GPIO_PORT_SELECT_PORT3
+} nrf_gpio_port_select_t;
+
+/**
+  * Simulated GPIO registers. Defined in HostHAL.cpp.
+  */
+extern volatile uint32_t host_gpio_out;
+extern volatile uint32_t host_gpio_in;
+extern volatile uint32_t host_gpio_dir;
+
+inline void nrf_gpio_range_cfg_output(uint32_t pin_range_start, uint32_t pin_range_end)
+{
+    for (; pin_range_start <= pin_range_end && pin_range_start < 32; pin_range_start++)
+        host_gpio_dir |= (1UL << pin_range_start);
+}
+
+inline void nrf_gpio_port_write(nrf_gpio_port_select_t port, uint8_t value)
+{
+    uint32_t shift = port * 8;
+
+    host_gpio_out = (host_gpio_out & ~(0xFFUL << shift)) | ((uint32_t)value << shift);
+}
+
+inline uint8_t nrf_gpio_port_read(nrf_gpio_port_select_t port)
+{
+    uint32_t shift = port * 8;
+
+    return (uint8_t)((((host_gpio_out & host_gpio_dir) | (host_gpio_in & ~host_gpio_dir)) >> shift) & 0xFF);
+}
+
+#endif
@@ -0,0 +1,679 @@
+/**
+  * Simulated hardware for host (Linux) builds of the micro:bit runtime.
+  *
+  * Implements the simulated mbed API declared in host/inc/mbed.h: simulated SRAM, the native heap,
+  * a virtual clock driving Ticker and Timeout, interrupt simulation, GPIO, memory backed I2C devices
+  * and a stdout backed serial port. See MicroBitHost.h for an overview.
+  */
+
+#include "MicroBit.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+// The maximum number of memory backed devices that can be attached to the simulated I2C bus.
+#define HOST_I2C_DEVICES                8
+
+// The size of the buffer used to hold data fed to the simulated serial port.
+#define HOST_SERIAL_BUFFER_SIZE         256
+
+// Pseudo exception numbers reported through __get_IPSR() while simulated interrupts are being serviced.
+#define HOST_IPSR_GPIOTE                (16 + GPIOTE_IRQn)
+#define HOST_IPSR_TIMER                 (16 + RTC1_IRQn)
+
+// Simulated radio, provided by HostRadio.cpp.
+bool host_radio_pending();
+void host_radio_service();
+
+/**
+  * Processor state.
+  */
+volatile uint32_t host_ipsr = 0;                // Nonzero while a simulated interrupt is being serviced.
+static bool host_primask = false;               // Set while interrupts are disabled.
+static bool host_irq_pending = false;           // Set when an interrupt fell due while it could not be serviced.
+
+/**
+  * Interrupt disabled statistics.
+  */
+static HostIrqStatistics irqStatistics;
+static uint64_t irqDisabledAt = 0;
+
+/**
+  * Virtual clock.
+  */
+static uint64_t host_now = 0;
+static TimerEvent *timers = NULL;
+
+/**
+  * GPIO state.
+  */
+volatile uint32_t host_gpio_out = 0;
+volatile uint32_t host_gpio_in = 0;
+volatile uint32_t host_gpio_dir = 0;
+
+static InterruptIn *interruptPins[32];
+static uint32_t edgePending = 0;
+static uint16_t analogValues[32];
+
+/**
+  * I2C devices.
+  */
+struct HostI2CDevice
+{
+    int         address;
+    uint8_t     *registers;
+    int         length;
+    int         pointer;
+};
+
+static HostI2CDevice i2cDevices[HOST_I2C_DEVICES];
+static int i2cDeviceCount = 0;
+
+/**
+  * Serial input.
+  */
+static char serialInput[HOST_SERIAL_BUFFER_SIZE];
+static int serialHead = 0;
+static int serialTail = 0;
+
+/**
+  * Native heap. A simple bump allocator over the SRAM between the SoftDevice region and the system stack.
+  * The runtime only uses the native heap to host its own nested heap, so only the most recent allocation
+  * can be released (which is sufficient for microbit_heap_init()).
+  */
+static uint32_t nativeHeapTop = MICROBIT_HEAP_SD_LIMIT;
+static uint32_t nativeHeapLast = 0;
+
+/**
+  * Maps simulated SRAM at its physical address. This runs before any static constructors in the runtime,
+  * as the SoftDevice heap and the system stack are accessed at fixed addresses.
+  */
+static void __attribute__((constructor(101))) host_sram_init()
+{
+    void *sram = mmap((void *)(uintptr_t)MICROBIT_SRAM_BASE, MICROBIT_SRAM_END - MICROBIT_SRAM_BASE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (sram != (void *)(uintptr_t)MICROBIT_SRAM_BASE)
+    {
+        fprintf(stderr, "host: unable to map simulated SRAM at 0x%08x\n", MICROBIT_SRAM_BASE);
+        _exit(1);
+    }
+}
+
+void *native_malloc(size_t size)
+{
+    uint32_t p = (nativeHeapTop + 7) & ~7;
+
+    if (size > MICROBIT_HEAP_END - p)
+        return NULL;
+
+    nativeHeapLast = nativeHeapTop;
+    nativeHeapTop = p + size;
+
+    return (void *)(uintptr_t)p;
+}
+
+void native_free(void *p)
+{
+    // Only the most recent allocation can be released.
+    if (p != NULL && ((nativeHeapLast + 7) & ~7) == (uint32_t)(uintptr_t)p)
+        nativeHeapTop = nativeHeapLast;
+}
+
+uint64_t host_cycles()
+{
+    return __rdtsc();
+}
+
+uint64_t host_time_us()
+{
+    return host_now;
+}
+
+void host_exit(int status)
+{
+    fflush(stdout);
+    fflush(stderr);
+    _exit(status);
+}
+
+/**
+  * Determines if interrupts can be serviced right now.
+  */
+static bool host_irq_allowed()
+{
+    return !host_primask && host_ipsr == 0;
+}
+
+/**
+  * Fires any timers that are due, in deadline order.
+  */
+void host_service_timers()
+{
+    while (timers != NULL && timers->getDeadline() <= host_now)
+    {
+        TimerEvent *t = timers;
+        timers = t->next;
+        t->active = false;
+
+        // Reschedule periodic timers before calling the handler, which may well detach or reattach the timer.
+        if (t->period)
+            t->insert(t->deadline + t->period, t->period);
+
+        host_ipsr = HOST_IPSR_TIMER;
+        t->handler.call();
+        host_ipsr = 0;
+    }
+}
+
+/**
+  * Services any pin change interrupts that are pending.
+  */
+static void host_service_gpio()
+{
+    while (edgePending)
+    {
+        int pin = __builtin_ctz(edgePending);
+        edgePending &= ~(1UL << pin);
+
+        if (interruptPins[pin])
+        {
+            host_ipsr = HOST_IPSR_GPIOTE;
+            interruptPins[pin]->edge((host_gpio_in >> pin) & 1);
+            host_ipsr = 0;
+        }
+    }
+}
+
+/**
+  * Services all pending interrupts, if the processor state allows it.
+  * Otherwise, the interrupts are left pending until interrupts are next enabled.
+  */
+static void host_service_interrupts()
+{
+    if (!host_irq_allowed())
+    {
+        host_irq_pending = true;
+        return;
+    }
+
+    do
+    {
+        uint64_t start = host_cycles();
+
+        host_irq_pending = false;
+
+        host_service_gpio();
+        host_service_timers();
+
+        if (host_radio_pending())
+            host_radio_service();
+
+        uint64_t cycles = host_cycles() - start;
+
+        irqStatistics.isrCount++;
+        irqStatistics.isrTotalCycles += cycles;
+        if (cycles > irqStatistics.isrMaxCycles)
+            irqStatistics.isrMaxCycles = cycles;
+
+    } while (host_irq_pending);
+}
+
+/**
+  * Determines if there is any interrupt ready to be serviced.
+  */
+static bool host_interrupt_ready()
+{
+    return host_irq_pending || edgePending || host_radio_pending() || (timers != NULL && timers->getDeadline() <= host_now);
+}
+
+void host_irq_disable()
+{
+    if (!host_primask)
+    {
+        host_primask = true;
+        irqStatistics.disableCount++;
+        irqDisabledAt = host_cycles();
+    }
+}
+
+void host_irq_enable()
+{
+    if (host_primask)
+    {
+        uint64_t cycles = host_cycles() - irqDisabledAt;
+
+        irqStatistics.totalCycles += cycles;
+        if (cycles > irqStatistics.maxCycles)
+            irqStatistics.maxCycles = cycles;
+
+        host_primask = false;
+    }
+
+    if (host_irq_pending && host_ipsr == 0)
+        host_service_interrupts();
+}
+
+uint32_t host_irq_disabled()
+{
+    return host_primask;
+}
+
+void host_irq_statistics(HostIrqStatistics *stats)
+{
+    *stats = irqStatistics;
+}
+
+void host_irq_statistics_reset()
+{
+    memset(&irqStatistics, 0, sizeof(irqStatistics));
+}
+
+void host_advance_us(uint64_t us)
+{
+    uint64_t target = host_now + us;
+
+    // Step through each timer deadline in turn, so that handlers observe the time they fell due.
+    while (timers != NULL && timers->getDeadline() <= target)
+    {
+        if (timers->getDeadline() > host_now)
+            host_now = timers->getDeadline();
+
+        if (!host_irq_allowed())
+        {
+            host_irq_pending = true;
+            break;
+        }
+
+        host_service_interrupts();
+    }
+
+    if (target > host_now)
+        host_now = target;
+}
+
+void host_wait_for_interrupt()
+{
+    if (!host_interrupt_ready())
+    {
+        if (timers == NULL)
+        {
+            fprintf(stderr, "host: processor halted with no interrupt sources enabled\n");
+            host_exit(1);
+        }
+
+        if (timers->getDeadline() > host_now)
+            host_now = timers->getDeadline();
+    }
+
+    host_service_interrupts();
+}
+
+namespace mbed {
+
+TimerEvent::TimerEvent() : deadline(0), period(0), active(false), next(NULL)
+{
+}
+
+TimerEvent::~TimerEvent()
+{
+    remove();
+}
+
+/**
+  * Adds this timer to the list of active timers, sorted by deadline.
+  * Timers with equal deadlines fire in the order they were inserted.
+  */
+void TimerEvent::insert(uint64_t t, uint64_t p)
+{
+    remove();
+
+    deadline = t;
+    period = p;
+    active = true;
+
+    TimerEvent **prev = &timers;
+    while (*prev != NULL && (*prev)->deadline <= t)
+        prev = &(*prev)->next;
+
+    next = *prev;
+    *prev = this;
+}
+
+void TimerEvent::remove()
+{
+    if (!active)
+        return;
+
+    for (TimerEvent **prev = &timers; *prev != NULL; prev = &(*prev)->next)
+    {
+        if (*prev == this)
+        {
+            *prev = next;
+            break;
+        }
+    }
+
+    next = NULL;
+    active = false;
+}
+
+DigitalOut::DigitalOut(PinName pin) : pin(pin)
+{
+    if (pin < 32)
+        host_gpio_dir |= (1UL << pin);
+}
+
+DigitalOut::DigitalOut(PinName pin, int value) : pin(pin)
+{
+    if (pin < 32)
+        host_gpio_dir |= (1UL << pin);
+
+    write(value);
+}
+
+void DigitalOut::write(int value)
+{
+    if (pin >= 32)
+        return;
+
+    if (value)
+        host_gpio_out |= (1UL << pin);
+    else
+        host_gpio_out &= ~(1UL << pin);
+}
+
+int DigitalOut::read()
+{
+    return pin < 32 ? (host_gpio_out >> pin) & 1 : 0;
+}
+
+DigitalIn::DigitalIn(PinName pin) : pin(pin)
+{
+    if (pin < 32)
+        host_gpio_dir &= ~(1UL << pin);
+}
+
+DigitalIn::DigitalIn(PinName pin, PinMode mode) : pin(pin)
+{
+    if (pin < 32)
+        host_gpio_dir &= ~(1UL << pin);
+
+    this->mode(mode);
+}
+
+void DigitalIn::mode(PinMode pull)
+{
+    if (pin >= 32)
+        return;
+
+    if (pull == PullUp)
+        host_gpio_in |= (1UL << pin);
+
+    if (pull == PullDown)
+        host_gpio_in &= ~(1UL << pin);
+}
+
+int DigitalIn::read()
+{
+    return pin < 32 ? (host_gpio_in >> pin) & 1 : 0;
+}
+
+InterruptIn::InterruptIn(PinName pin) : pin(pin)
+{
+    if (pin < 32)
+    {
+        host_gpio_dir &= ~(1UL << pin);
+        interruptPins[pin] = this;
+    }
+}
+
+InterruptIn::~InterruptIn()
+{
+    if (pin < 32 && interruptPins[pin] == this)
+        interruptPins[pin] = NULL;
+}
+
+int InterruptIn::read()
+{
+    return pin < 32 ? (host_gpio_in >> pin) & 1 : 0;
+}
+
+void InterruptIn::mode(PinMode pull)
+{
+    if (pin >= 32)
+        return;
+
+    if (pull == PullUp)
+        host_gpio_in |= (1UL << pin);
+
+    if (pull == PullDown)
+        host_gpio_in &= ~(1UL << pin);
+}
+
+/**
+  * Invokes the handler for a rising (value = 1) or falling (value = 0) edge on this pin.
+  */
+void InterruptIn::edge(int value)
+{
+    if (value)
+        riseHandler.call();
+    else
+        fallHandler.call();
+}
+
+AnalogIn::AnalogIn(PinName pin) : pin(pin)
+{
+}
+
+unsigned short AnalogIn::read_u16()
+{
+    return pin < 32 ? analogValues[pin] : 0;
+}
+
+float AnalogIn::read()
+{
+    return (float)read_u16() / 65535.0f;
+}
+
+I2C::I2C(PinName, PinName) : _hz(100000)
+{
+    _i2c.i2c = NRF_TWI1;
+}
+
+void I2C::frequency(int hz)
+{
+    _hz = hz;
+}
+
+/**
+  * Finds the device at the given address on the simulated bus.
+  */
+static HostI2CDevice *host_i2c_device(int address)
+{
+    for (int i = 0; i < i2cDeviceCount; i++)
+        if (i2cDevices[i].address == (address & 0xFE))
+            return &i2cDevices[i];
+
+    return NULL;
+}
+
+int I2C::read(int address, char *data, int length, bool)
+{
+    HostI2CDevice *device = host_i2c_device(address);
+
+    if (device == NULL)
+        return 1;
+
+    for (int i = 0; i < length; i++)
+    {
+        data[i] = device->registers[device->pointer];
+        device->pointer = (device->pointer + 1) % device->length;
+    }
+
+    return 0;
+}
+
+int I2C::write(int address, const char *data, int length, bool)
+{
+    HostI2CDevice *device = host_i2c_device(address);
+
+    if (device == NULL)
+        return 1;
+
+    for (int i = 0; i < length; i++)
+    {
+        if (i == 0)
+        {
+            device->pointer = (uint8_t)data[0] % device->length;
+            continue;
+        }
+
+        device->registers[device->pointer] = data[i];
+        device->pointer = (device->pointer + 1) % device->length;
+    }
+
+    return 0;
+}
+
+Serial::Serial(PinName, PinName, const char *) : _baud(9600)
+{
+}
+
+Serial::~Serial()
+{
+}
+
+void Serial::baud(int baudrate)
+{
+    _baud = baudrate;
+}
+
+int Serial::readable()
+{
+    return serialHead != serialTail;
+}
+
+int Serial::writeable()
+{
+    return 1;
+}
+
+int Serial::printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    for (int i = 0; i < length && i < (int)sizeof(buffer) - 1; i++)
+        _putc(buffer[i]);
+
+    return length;
+}
+
+int Serial::putc(int c)
+{
+    return _putc(c);
+}
+
+int Serial::getc()
+{
+    return _getc();
+}
+
+ssize_t Serial::write(const void *buffer, size_t length)
+{
+    const char *data = (const char *)buffer;
+
+    for (size_t i = 0; i < length; i++)
+        _putc(data[i]);
+
+    return length;
+}
+
+int Serial::_putc(int c)
+{
+    return fputc(c, stdout);
+}
+
+/**
+  * Reads the next character fed to the serial port by the host.
+  * Unlike the device, this does not block: EOF is returned if no data is available.
+  */
+int Serial::_getc()
+{
+    if (serialHead == serialTail)
+        return EOF;
+
+    int c = (unsigned char)serialInput[serialTail];
+    serialTail = (serialTail + 1) % HOST_SERIAL_BUFFER_SIZE;
+
+    return c;
+}
+
+} // namespace mbed
+
+int host_gpio_read(PinName pin)
+{
+    if (pin >= 32)
+        return 0;
+
+    return (((host_gpio_out & host_gpio_dir) | (host_gpio_in & ~host_gpio_dir)) >> pin) & 1;
+}
+
+void host_gpio_write(PinName pin, int value)
+{
+    if (pin >= 32)
+        return;
+
+    uint32_t old = host_gpio_in;
+
+    if (value)
+        host_gpio_in |= (1UL << pin);
+    else
+        host_gpio_in &= ~(1UL << pin);
+
+    if (old != host_gpio_in && interruptPins[pin])
+    {
+        edgePending |= (1UL << pin);
+        host_service_interrupts();
+    }
+}
+
+void host_analog_write(PinName pin, uint16_t value)
+{
+    if (pin < 32)
+        analogValues[pin] = value;
+}
+
+int host_i2c_attach(int address, uint8_t *registers, int length)
+{
+    if (i2cDeviceCount == HOST_I2C_DEVICES || registers == NULL || length <= 0)
+        return i2cDeviceCount == HOST_I2C_DEVICES ? MICROBIT_NO_RESOURCES : MICROBIT_INVALID_PARAMETER;
+
+    i2cDevices[i2cDeviceCount].address = address & 0xFE;
+    i2cDevices[i2cDeviceCount].registers = registers;
+    i2cDevices[i2cDeviceCount].length = length;
+    i2cDevices[i2cDeviceCount].pointer = 0;
+    i2cDeviceCount++;
+
+    return MICROBIT_OK;
+}
+
+void host_serial_feed(const char *data, int length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        int next = (serialHead + 1) % HOST_SERIAL_BUFFER_SIZE;
+
+        if (next == serialTail)
+            break;
+
+        serialInput[serialHead] = data[i];
+        serialHead = next;
+    }
+}
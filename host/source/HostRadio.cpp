@@ -0,0 +1,140 @@
+/**
+  * Simulated nrf51822 peripherals for host (Linux) builds of the micro:bit runtime.
+  *
+  * Provides the RADIO, CLOCK, ADC and TWI register blocks and the NVIC. The RADIO is modelled as a loopback
+  * device with a single packet in the air: a packet transmitted with TASKS_START is received by the same device
+  * once it is back in receive mode, provided it is listening on the same group (PREFIX0). Delivery takes place
+  * at the next interrupt service point, in the same way as it would on the device.
+  */
+
+#include "MicroBit.h"
+
+// Pseudo exception number reported through __get_IPSR() while RADIO_IRQHandler is being run.
+#define HOST_IPSR_RADIO                 (16 + RADIO_IRQn)
+
+// The largest packet the simulated radio will carry, including the length field.
+#define HOST_RADIO_MAX_PACKET           (MICROBIT_RADIO_MAX_PACKET_SIZE + MICROBIT_RADIO_HEADER_SIZE)
+
+extern "C" void RADIO_IRQHandler(void);
+
+enum HostRadioState
+{
+    RADIO_STATE_DISABLED,
+    RADIO_STATE_RX_IDLE,
+    RADIO_STATE_RX,
+    RADIO_STATE_TX_IDLE
+};
+
+static HostRadioState radioState = RADIO_STATE_DISABLED;
+
+// The packet currently "in the air", and the group it was sent to.
+static uint8_t airPacket[HOST_RADIO_MAX_PACKET];
+static uint32_t airPrefix = 0;
+static bool airValid = false;
+
+// Interrupts enabled in the NVIC.
+static uint32_t nvicEnabled = 0;
+
+static void radio_txen()
+{
+    radioState = RADIO_STATE_TX_IDLE;
+    host_radio.EVENTS_READY.pending = true;
+}
+
+static void radio_rxen()
+{
+    radioState = RADIO_STATE_RX_IDLE;
+    host_radio.EVENTS_READY.pending = true;
+}
+
+static void radio_start()
+{
+    if (radioState == RADIO_STATE_RX_IDLE)
+        radioState = RADIO_STATE_RX;
+
+    if (radioState == RADIO_STATE_TX_IDLE)
+    {
+        uint8_t *packet = (uint8_t *)(uintptr_t)host_radio.PACKETPTR;
+        int length = min(packet[0] + 1, HOST_RADIO_MAX_PACKET);
+
+        memcpy(airPacket, packet, length);
+        airPacket[0] = length - 1;
+        airPrefix = host_radio.PREFIX0;
+        airValid = true;
+
+        host_radio.EVENTS_END.pending = true;
+    }
+}
+
+static void radio_disable()
+{
+    radioState = RADIO_STATE_DISABLED;
+    host_radio.EVENTS_DISABLED.pending = true;
+}
+
+static void clock_hfclkstart()
+{
+    host_clock.EVENTS_HFCLKSTARTED.pending = true;
+}
+
+NRF_RADIO_Type host_radio = { radio_txen, radio_rxen, radio_start, radio_disable };
+NRF_CLOCK_Type host_clock = { clock_hfclkstart };
+NRF_ADC_Type host_adc;
+NRF_TWI_Type host_twi[2];
+
+/**
+  * Determines if a packet is ready to be delivered to the receiver.
+  */
+bool host_radio_pending()
+{
+    return airValid && radioState == RADIO_STATE_RX && (nvicEnabled & (1UL << RADIO_IRQn)) && (host_radio.INTENSET & 0x08);
+}
+
+/**
+  * Delivers the packet in the air to the receive buffer, and raises the RADIO interrupt.
+  */
+void host_radio_service()
+{
+    if (!host_radio_pending())
+        return;
+
+    airValid = false;
+
+    // Packets sent to other groups are filtered out by the address match, and never reach the receiver.
+    if (airPrefix != host_radio.PREFIX0)
+        return;
+
+    memcpy((void *)(uintptr_t)host_radio.PACKETPTR, airPacket, airPacket[0] + 1);
+
+    host_radio.CRCSTATUS = 1;
+    host_radio.EVENTS_END = 1;
+    radioState = RADIO_STATE_RX_IDLE;
+
+    host_ipsr = HOST_IPSR_RADIO;
+    RADIO_IRQHandler();
+    host_ipsr = 0;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    nvicEnabled |= (1UL << irq);
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    nvicEnabled &= ~(1UL << irq);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type)
+{
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type)
+{
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "host: system reset\n");
+    host_exit(0);
+}
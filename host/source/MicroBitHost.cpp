@@ -0,0 +1,316 @@
+/**
+  * Host (Linux) implementation of the MicroBit device class.
+  * Mirrors source/MicroBit.cpp, for the subset of components available in the simulation.
+  */
+
+#include "MicroBit.h"
+
+// Transmit power levels, in dBm. The same values as MicroBitBLEManager.
+const int8_t MICROBIT_BLE_POWER_LEVEL[] = {-30, -20, -16, -12, -8, -4, 0, 4};
+
+/**
+  * custom function for panic for malloc & new due to scoping issue.
+  */
+void panic(int statusCode)
+{
+    uBit.panic(statusCode);
+}
+
+/**
+  * Perform a hard reset of the micro:bit. On the host, this terminates the simulation.
+  */
+void microbit_reset()
+{
+    NVIC_SystemReset();
+}
+
+/**
+  * The listeners of system components that are fixed at compile time. Just those common to every platform,
+  * as the buttons aren't simulated.
+  */
+const MicroBitStaticListener microbit_static_listeners[] = {
+    MICROBIT_STATIC_LISTENERS_CORE
+};
+
+extern const int microbit_static_listener_count = sizeof(microbit_static_listeners) / sizeof(MicroBitStaticListener);
+
+/**
+  * Constructor.
+  * Create a representation of a simulated MicroBit device as a global singleton.
+  */
+MicroBit::MicroBit() :
+    flags(0x00),
+    i2c(MICROBIT_PIN_SDA, MICROBIT_PIN_SCL),
+    serial(USBTX, USBRX),
+    MessageBus(),
+    display(MICROBIT_ID_DISPLAY, MICROBIT_DISPLAY_WIDTH, MICROBIT_DISPLAY_HEIGHT),
+    radio(MICROBIT_ID_RADIO),
+    ble(NULL)
+{
+}
+
+/**
+  * Post constructor initialisation method.
+  * Registers the system components, and starts the system ticker.
+  */
+void MicroBit::init()
+{
+    //add the display to the systemComponent array
+    addSystemComponent(&uBit.display);
+
+    //add the message bus to the idle array
+    addIdleComponent(&uBit.MessageBus);
+
+    // Deliver events from dedicated fibers, if so configured.
+    MessageBus.startEventFibers();
+
+    // Seed our random number generator
+    seedRandom();
+
+    tickPeriod = MICROBIT_DEFAULT_TICK_PERIOD;
+
+    // Start refreshing the Matrix Display
+    startSystemTick(0);
+}
+
+/**
+  * Terminates the simulation.
+  */
+void MicroBit::reset()
+{
+    microbit_reset();
+}
+
+/**
+  * Delay for the given amount of time.
+  * If the scheduler is running, this will deschedule the current fiber and perform
+  * a power efficent, concurrent sleep operation.
+  * If the scheduler is disabled or we're running in an interrupt context, this
+  * will revert to a busy wait.
+  *
+  * @param milliseconds the amount of time, in ms, to wait for. This number cannot be negative.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER milliseconds is less than zero.
+  */
+int MicroBit::sleep(int milliseconds)
+{
+    //sanity check, we can't time travel... (yet?)
+    if(milliseconds < 0)
+        return MICROBIT_INVALID_PARAMETER;
+
+    if (flags & MICROBIT_FLAG_SCHEDULER_RUNNING)
+        fiber_sleep(milliseconds);
+    else
+        wait_ms(milliseconds);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Generate a random number in the given range, using the same Galois LFSR as the device.
+  * @param max the upper range to generate a number for. This number cannot be negative
+  * @return A random, natural number between 0 and the max-1. Or MICROBIT_INVALID_PARAMETER if max is <= 0.
+  */
+int MicroBit::random(int max)
+{
+    uint32_t m, result;
+
+    if(max <= 0)
+        return MICROBIT_INVALID_PARAMETER;
+
+    // Our maximum return value is actually one less than passed
+    max--;
+
+    do {
+        m = (uint32_t)max;
+        result = 0;
+        do {
+            uint32_t rnd = randomValue;
+
+            rnd = ((((rnd >> 31)
+                          ^ (rnd >> 6)
+                          ^ (rnd >> 4)
+                          ^ (rnd >> 2)
+                          ^ (rnd >> 1)
+                          ^ rnd)
+                          & 0x0000001)
+                          << 31 )
+                          | (rnd >> 1);
+
+            randomValue = rnd;
+
+            result = ((result << 1) | (rnd & 0x00000001));
+        } while(m >>= 1);
+    } while (result > (uint32_t)max);
+
+    return result;
+}
+
+/**
+  * Seed the random number generator. There is no hardware RNG on the host, so a fixed seed is
+  * used to keep runs deterministic.
+  */
+void MicroBit::seedRandom()
+{
+    randomValue = 0xBBC5EED;
+}
+
+/**
+  * Seed the pseudo random number generator using the given 32-bit value.
+  */
+void MicroBit::seedRandom(uint32_t seed)
+{
+    randomValue = seed;
+}
+
+/**
+  * Periodic callback. Used by MicroBitDisplay, FiberScheduler and I2C sensors to
+  * provide a power efficient sense of time.
+  */
+void MicroBit::systemTick()
+{
+    // If the system tick was suspended, this is the single tick that was scheduled in its place.
+    // Bring the system time up to date (scheduler_tick() accounts for the current tick period, as usual).
+    if (flags & MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED)
+        restartSystemTick();
+
+    // Scheduler callback. We do this here just as a single timer is more efficient. :-)
+    if (uBit.flags & MICROBIT_FLAG_SCHEDULER_RUNNING)
+        scheduler_tick();
+
+    //work out if any idle components need processing, if so prioritise the idle thread
+    for(int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if(idleThreadComponents[i] != NULL && idleThreadComponents[i]->isIdleCallbackNeeded())
+        {
+            fiber_flags |= MICROBIT_FLAG_DATA_READY;
+            break;
+        }
+
+    //update any components in the systemComponents array
+    for(int i = 0; i < MICROBIT_SYSTEM_COMPONENTS; i++)
+        if(systemTickComponents[i] != NULL)
+            systemTickComponents[i]->systemTick();
+}
+
+/**
+  * System tasks to be executed by the idle thread when the Micro:Bit isn't busy or when data needs to be read.
+  */
+void MicroBit::systemTasks()
+{
+    //call the idleTick member function indiscriminately
+    for(int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if(idleThreadComponents[i] != NULL)
+            idleThreadComponents[i]->idleTick();
+
+    fiber_flags &= ~MICROBIT_FLAG_DATA_READY;
+}
+
+/**
+  * add a component to the array of components which invocate the systemTick member function during a systemTick
+  * @param component The component to add.
+  * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+  */
+int MicroBit::addSystemComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_SYSTEM_COMPONENTS && systemTickComponents[i] != NULL)
+        i++;
+
+    if(i == MICROBIT_SYSTEM_COMPONENTS)
+        return MICROBIT_NO_RESOURCES;
+
+    systemTickComponents[i] = component;
+    return MICROBIT_OK;
+}
+
+/**
+  * remove a component from the array of components
+  * @param component The component to remove.
+  * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+  */
+int MicroBit::removeSystemComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_SYSTEM_COMPONENTS && systemTickComponents[i] != component)
+        i++;
+
+    if(i == MICROBIT_SYSTEM_COMPONENTS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    systemTickComponents[i] = NULL;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * add a component to the array of components which invocate the systemTick member function during a systemTick
+  * @param component The component to add.
+  * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+  */
+int MicroBit::addIdleComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_IDLE_COMPONENTS && idleThreadComponents[i] != NULL)
+        i++;
+
+    if(i == MICROBIT_IDLE_COMPONENTS)
+        return MICROBIT_NO_RESOURCES;
+
+    idleThreadComponents[i] = component;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * remove a component from the array of components
+  * @param component The component to remove.
+  * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+  */
+int MicroBit::removeIdleComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_IDLE_COMPONENTS && idleThreadComponents[i] != component)
+        i++;
+
+    if(i == MICROBIT_IDLE_COMPONENTS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    idleThreadComponents[i] = NULL;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Determine the time since this MicroBit was last reset.
+  * @return The time since the last reset, in milliseconds.
+  */
+unsigned long MicroBit::systemTime()
+{
+    return ticks;
+}
+
+/**
+  * Determine the version of the micro:bit runtime currently in use.
+  * @return A textual description of the currentlt executing micro:bit runtime.
+  */
+const char *MicroBit::systemVersion()
+{
+    return MICROBIT_DAL_VERSION;
+}
+
+/**
+  * Reports the given panic code on stderr, and terminates the simulation with that code as the exit status.
+  * If MICROBIT_TRACE is enabled, the event trace is first written to the serial port.
+  * @param statusCode the status code of the associated error.
+  */
+void MicroBit::panic(int statusCode)
+{
+    microbit_trace(MICROBIT_TRACE_PANIC, statusCode, 0, 0);
+    microbit_trace_dump();
+
+    fprintf(stderr, "host: panic %d at %llu us\n", statusCode, (unsigned long long)host_time_us());
+    host_exit(statusCode ? statusCode : 1);
+}
@@ -0,0 +1,63 @@
+/**
+  * Super-main for host (Linux) builds of the micro:bit runtime.
+  *
+  * The runtime assumes that the system stack lies at the top of SRAM (CORTEX_M0_STACK_BASE), as the
+  * scheduler pages fiber stacks in and out of that region. The host's main() therefore switches onto
+  * the simulated system stack, and then brings up the runtime just as MicroBitSuperMain.cpp does on the device.
+  */
+
+#include "MicroBit.h"
+
+MicroBit        uBit;
+InterruptIn     resetButton(MICROBIT_PIN_BUTTON_RESET);
+
+/**
+  * Entry point of the simulated device, running on the simulated system stack.
+  */
+void host_main()
+{
+    // Bring up soft reset button.
+    resetButton.mode(PullUp);
+    resetButton.fall(microbit_reset);
+
+#if CONFIG_ENABLED(MICROBIT_DBG)
+    uBit.serial.printf("micro:bit runtime DAL version %s\n", MICROBIT_DAL_VERSION);
+#endif
+
+    // Bring up our nested heap allocator.
+    microbit_heap_init();
+
+    // Bring up fiber scheduler
+    scheduler_init();
+
+    // Bring up random number generator, display and system timers.
+    uBit.init();
+
+    // Provide time for all threaded initialisers to complete.
+    uBit.sleep(100);
+
+    app_main();
+
+    // If app_main exits, there may still be other fibers running, registered event handlers etc.
+    // Simply release this fiber, which will mean we enter the scheduler. Worse case, we then
+    // sit in the idle task forever, until the simulation is ended by the host.
+    release_fiber();
+
+    // We should never get here, but just in case.
+    host_exit(0);
+}
+
+int main()
+{
+    Cortex_M0_TCB tcb;
+
+    // Switch onto the simulated system stack, and never come back.
+    memset(&tcb, 0, sizeof(tcb));
+    tcb.SP = CORTEX_M0_STACK_BASE - 0x04;
+    tcb.LR = (uint32_t)(uintptr_t) &host_main;
+    tcb.stack_base = CORTEX_M0_STACK_BASE;
+
+    swap_context(NULL, &tcb, 0, 0);
+
+    return 0;
+}
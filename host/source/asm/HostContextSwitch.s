@@ -0,0 +1,174 @@
+# x86-64 implementation of the fiber context switching primitives, for host (Linux) builds.
+#
+# This follows CortexContextSwitch.s.gcc as closely as possible, using the same Cortex_M0_TCB layout:
+#
+# - The callee saved registers (RBX, RBP, R12-R15) are stored as 64 bit values over the R0-R11 slots.
+# - SP and LR hold the stack pointer and return address of the caller. The host build maps SRAM and code
+#   into the bottom 4GB of the address space, so both fit in 32 bits.
+# - Paged stacks are copied a word at a time, between SP and the fiber's stack_base.
+#
+# When a new fiber is first scheduled in, the R0, R1 and R2 slots of its TCB hold the arguments for its
+# entry point (see launch_new_fiber), so these are also loaded into the first three argument registers.
+
+    .intel_syntax noprefix
+    .text
+
+    .global swap_context
+    .global save_context
+    .global save_register_context
+    .global restore_register_context
+
+# RDI Contains a pointer to the TCB of the fibre being scheduled out.
+# RSI Contains a pointer to the TCB of the fibre being scheduled in.
+# EDX Contains a pointer to the base of the stack of the fibre being scheduled out.
+# ECX Contains a pointer to the base of the stack of the fibre being scheduled in.
+
+swap_context:
+
+    # 32 bit parameters are not guaranteed to be zero extended.
+    mov     edx, edx
+    mov     ecx, ecx
+
+    # Skip this is we're given a NULL parameter for the TCB
+    test    rdi, rdi
+    jz      store_context_complete
+
+    mov     [rdi+0], rbx
+    mov     [rdi+8], rbp
+    mov     [rdi+16], r12
+    mov     [rdi+24], r13
+    mov     [rdi+32], r14
+    mov     [rdi+40], r15
+
+    # Now the Stack and Link Register, as they will be once we return to our caller.
+    lea     rax, [rsp+8]
+    mov     [rdi+52], eax
+    mov     rax, [rsp]
+    mov     [rdi+56], eax
+
+    # Finally, Copy the stack.
+    # Skip this is we're given a NULL parameter for the stack.
+    test    rdx, rdx
+    jz      store_context_complete
+
+    mov     r8d, [rdi+60]           # Load R8 with the fiber's defined stack_base.
+    lea     r9, [rsp+8]
+store_stack:
+    cmp     r8, r9
+    jbe     store_context_complete
+    sub     r8, 4
+    sub     rdx, 4
+    mov     eax, [r8]
+    mov     [rdx], eax
+    jmp     store_stack
+
+store_context_complete:
+
+    # Now page in the new context.
+    mov     r8d, [rsi+56]
+    mov     r9d, [rsi+52]
+    mov     rsp, r9
+
+    # Copy the stack in.
+    # n.b. we do this after setting the SP to make comparisons easier.
+    test    rcx, rcx
+    jz      restore_stack_complete
+
+    mov     r10d, [rsi+60]          # Load R10 with the fiber's defined stack_base.
+restore_stack:
+    cmp     r10, r9
+    jbe     restore_stack_complete
+    sub     r10, 4
+    sub     rcx, 4
+    mov     eax, [rcx]
+    mov     [r10], eax
+    jmp     restore_stack
+
+restore_stack_complete:
+    mov     rbx, [rsi+0]
+    mov     rbp, [rsi+8]
+    mov     r12, [rsi+16]
+    mov     r13, [rsi+24]
+    mov     r14, [rsi+32]
+    mov     r15, [rsi+40]
+
+    # Entry point arguments, for newly created fibers.
+    mov     edi, [rsi+0]
+    mov     edx, [rsi+8]
+    mov     esi, [rsi+4]
+
+    # Return to caller (scheduler).
+    jmp     r8
+
+
+# RDI Contains a pointer to the TCB of the fibre to snapshot
+# ESI Contains a pointer to the base of the stack of the fibre being snapshotted
+
+save_context:
+
+    mov     esi, esi
+
+    mov     [rdi+0], rbx
+    mov     [rdi+8], rbp
+    mov     [rdi+16], r12
+    mov     [rdi+24], r13
+    mov     [rdi+32], r14
+    mov     [rdi+40], r15
+
+    lea     r9, [rsp+8]
+    mov     [rdi+52], r9d
+    mov     rax, [rsp]
+    mov     [rdi+56], eax
+
+    mov     r8d, [rdi+60]           # Load R8 with the fiber's defined stack_base.
+store_stack1:
+    cmp     r8, r9
+    jbe     store_stack1_complete
+    sub     r8, 4
+    sub     rsi, 4
+    mov     eax, [r8]
+    mov     [rsi], eax
+    jmp     store_stack1
+
+store_stack1_complete:
+    ret
+
+
+# RDI Contains a pointer to the TCB of the fiber to snapshot
+
+save_register_context:
+
+    mov     [rdi+0], rbx
+    mov     [rdi+8], rbp
+    mov     [rdi+16], r12
+    mov     [rdi+24], r13
+    mov     [rdi+32], r14
+    mov     [rdi+40], r15
+
+    lea     rax, [rsp+8]
+    mov     [rdi+52], eax
+    mov     rax, [rsp]
+    mov     [rdi+56], eax
+
+    ret
+
+
+# RDI Contains a pointer to the TCB of the fiber to restore
+
+restore_register_context:
+
+    mov     r8d, [rdi+56]
+    mov     r9d, [rdi+52]
+    mov     rsp, r9
+
+    mov     rbx, [rdi+0]
+    mov     rbp, [rdi+8]
+    mov     r12, [rdi+16]
+    mov     r13, [rdi+24]
+    mov     r14, [rdi+32]
+    mov     r15, [rdi+40]
+
+    # Return to caller (normally the scheduler).
+    jmp     r8
+
+    .section .note.GNU-stack,"",@progbits
@@ -0,0 +1,183 @@
+/**
+  * Decoder for the heap profile of the micro:bit runtime (see MICROBIT_HEAP_PROFILE in MicroBitConfig.h).
+  *
+  * Reads the output of the serial port of a micro:bit, as captured from microbit_heap_profile_dump() or on
+  * running out of memory, and writes each profile found in it as a table of allocation sites, holding the
+  * most memory first. Any other output on the serial port is ignored.
+  *
+  *   heap-profile-decoder [-e program.elf] [-a addr2line] [capture.txt]
+  *
+  * If given the ELF file of the program that was profiled, the address of each site is turned into a function
+  * and source line by running addr2line (by default arm-none-eabi-addr2line; use -a addr2line for a host build).
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+struct Site
+{
+    unsigned    address;
+    unsigned    allocations;
+    unsigned    liveBlocks;
+    unsigned    liveBytes;
+    unsigned    peakBytes;
+    unsigned    minSize;
+    unsigned    maxSize;
+    char        name[160];
+};
+
+static Site sites[256];
+
+/**
+  * Names each site by its address.
+  */
+static void name_by_address(Site *s, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (s[i].address)
+            sprintf(s[i].name, "0x%08x", s[i].address);
+        else
+            strcpy(s[i].name, "(other sites)");
+    }
+}
+
+/**
+  * Names a site by the function and source line it lies in, using addr2line. Where the allocator was inlined
+  * (e.g. operator new), the outermost function is the one named.
+  * @return true on success, or false if addr2line could not be run or did not know the address.
+  */
+static bool name_by_symbol(Site &s, const char *elf, const char *addr2line)
+{
+    char command[512];
+    char function[256];
+    char line[256];
+    bool found = false;
+
+    // A return address points after the call, which may be on a following line. Look up the call itself.
+    // On Cortex-M, return addresses also have their lowest bit set, marking Thumb code.
+    snprintf(command, sizeof(command), "%s -f -C -i -e '%s' 0x%x", addr2line, elf, (s.address & ~1) - 1);
+
+    FILE *symbols = popen(command, "r");
+
+    if (symbols == NULL)
+        return false;
+
+    // Each function the address is inlined into follows the last, outermost last.
+    while (fgets(function, sizeof(function), symbols) != NULL && fgets(line, sizeof(line), symbols) != NULL)
+    {
+        function[strcspn(function, "\n")] = 0;
+        line[strcspn(line, "\n (")] = 0;
+
+        // Only the file name is of interest, not where it was built.
+        const char *file = strrchr(line, '/');
+        file = file ? file + 1 : line;
+
+        if (strcmp(function, "??") != 0)
+        {
+            snprintf(s.name, sizeof(s.name), "%s  %s", function, file);
+            found = true;
+        }
+    }
+
+    return pclose(symbols) == 0 && found;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    const char *elf = NULL;
+    const char *addr2line = "arm-none-eabi-addr2line";
+    char line[256];
+    int profiles = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+            elf = argv[++i];
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            addr2line = argv[++i];
+        else if ((in = fopen(argv[i], "r")) == NULL)
+        {
+            fprintf(stderr, "heap-profile-decoder: can't open %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        unsigned shown, seen, time;
+        int count = 0;
+
+        if (sscanf(line, "heap profile %x %x %x", &shown, &seen, &time) != 3)
+            continue;
+
+        while (fgets(line, sizeof(line), in) != NULL && strncmp(line, "heap profile end", 16) != 0)
+        {
+            if (count == 256)
+                continue;
+
+            Site &s = sites[count];
+
+            if (sscanf(line, "%x %x %x %x %x %x %x", &s.address, &s.allocations, &s.liveBlocks,
+                    &s.liveBytes, &s.peakBytes, &s.minSize, &s.maxSize) == 7)
+                count++;
+        }
+
+        name_by_address(sites, count);
+
+        for (int i = 0; elf && i < count; i++)
+        {
+            if (sites[i].address && !name_by_symbol(sites[i], elf, addr2line))
+            {
+                fprintf(stderr, "heap-profile-decoder: couldn't look up sites in %s with %s\n", elf, addr2line);
+                elf = NULL;
+            }
+        }
+
+        printf("heap profile %d: %u of %u allocation sites, over %.3f s\n\n", ++profiles, shown, seen, time / 1000.0);
+        printf("%10s %8s %10s %10s %10s %13s  %s\n", "live bytes", "live", "peak bytes", "allocs", "allocs/s", "sizes", "site");
+
+        unsigned liveBytes = 0, liveBlocks = 0, allocations = 0;
+        bool overflowed = false;
+
+        for (int i = 0; i < count; i++)
+        {
+            Site &s = sites[i];
+            char sizes[32];
+
+            if (s.minSize == s.maxSize)
+                sprintf(sizes, "%u", s.minSize);
+            else
+                sprintf(sizes, "%u-%u", s.minSize, s.maxSize);
+
+            printf("%10u %8u %10u %10u %10.1f %13s  %s\n", s.liveBytes, s.liveBlocks, s.peakBytes, s.allocations,
+                time ? s.allocations * 1000.0 / time : 0.0, sizes, s.name);
+
+            liveBytes += s.liveBytes;
+            liveBlocks += s.liveBlocks;
+            allocations += s.allocations;
+
+            if (s.address == 0)
+                overflowed = true;
+        }
+
+        printf("%10u %8u %10s %10u %10.1f %13s  total of the sites shown\n", liveBytes, liveBlocks, "", allocations,
+            time ? allocations * 1000.0 / time : 0.0, "");
+
+        if ((unsigned) count != shown)
+            printf("warning: expected %u sites, the capture may be truncated\n", shown);
+
+        if (overflowed)
+            printf("note: the site table filled up, so allocations from further sites are counted as (other sites)\n");
+
+        printf("\n");
+    }
+
+    if (profiles == 0)
+        fprintf(stderr, "heap-profile-decoder: no heap profile found\n");
+
+    return profiles ? 0 : 1;
+}
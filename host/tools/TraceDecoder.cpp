@@ -0,0 +1,219 @@
+/**
+  * Decoder for the event trace of the micro:bit runtime (see MicroBitTrace.h).
+  *
+  * Reads the output of the serial port of a micro:bit, as captured from microbit_trace_dump() or a panic, and
+  * writes each trace found in it as a readable timeline, oldest record first, followed by a summary.
+  * Any other output on the serial port is ignored.
+  *
+  *   trace-decoder [capture.txt]
+  *
+  * Times are shown relative to the point the trace was dumped. Fibers are given short names (F1, F2, ...)
+  * in the order they appear, and event sources are named where they are components of the runtime.
+  */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "MicroBitTrace.h"
+#include "MicroBitComponent.h"
+
+// Most distinct fibers named in a single trace.
+#define TRACE_DECODER_FIBERS        64
+
+struct ComponentName
+{
+    uint16_t    id;
+    const char  *name;
+};
+
+static const ComponentName componentNames[] = {
+    { MICROBIT_ID_BUTTON_A, "BUTTON_A" },
+    { MICROBIT_ID_BUTTON_B, "BUTTON_B" },
+    { MICROBIT_ID_BUTTON_RESET, "BUTTON_RESET" },
+    { MICROBIT_ID_ACCELEROMETER, "ACCELEROMETER" },
+    { MICROBIT_ID_COMPASS, "COMPASS" },
+    { MICROBIT_ID_DISPLAY, "DISPLAY" },
+    { MICROBIT_ID_BUTTON_AB, "BUTTON_AB" },
+    { MICROBIT_ID_GESTURE, "GESTURE" },
+    { MICROBIT_ID_THERMOMETER, "THERMOMETER" },
+    { MICROBIT_ID_RADIO, "RADIO" },
+    { MICROBIT_ID_RADIO_DATA_READY, "RADIO_DATA_READY" },
+    { MICROBIT_ID_NOTIFY, "NOTIFY" },
+    { MICROBIT_ID_NOTIFY_ONE, "NOTIFY_ONE" }
+};
+
+static const char *dropReasons[] = { "?", "event queue full", "listener busy", "listener queue full" };
+
+// The fibers seen in the current trace, by the address recorded for them. Their names are their index + 1.
+static uint16_t fibers[TRACE_DECODER_FIBERS];
+static int fiberCount;
+
+// The address recorded for the idle fiber, once it has been seen.
+static uint16_t idleFiber;
+static bool idleFiberSeen;
+
+/**
+  * Formats the name of an event source.
+  */
+static const char *source_name(uint16_t id, char *buffer)
+{
+    for (unsigned i = 0; i < sizeof(componentNames) / sizeof(ComponentName); i++)
+    {
+        if (componentNames[i].id == id)
+        {
+            sprintf(buffer, "%s(%d)", componentNames[i].name, id);
+            return buffer;
+        }
+    }
+
+    if (id >= MICROBIT_ID_IO_P0 && id <= MICROBIT_ID_IO_P19)
+        sprintf(buffer, "IO_PIN(%d)", id);
+    else
+        sprintf(buffer, "%d", id);
+
+    return buffer;
+}
+
+/**
+  * Formats the name of a fiber, naming it if it hasn't been seen before.
+  */
+static const char *fiber_name(uint16_t address, char *buffer)
+{
+    int i = 0;
+
+    if (idleFiberSeen && address == idleFiber)
+        return strcpy(buffer, "idle");
+
+    while (i < fiberCount && fibers[i] != address)
+        i++;
+
+    if (i == fiberCount && fiberCount < TRACE_DECODER_FIBERS)
+        fibers[fiberCount++] = address;
+
+    if (i < TRACE_DECODER_FIBERS)
+        sprintf(buffer, "F%d", i + 1);
+    else
+        sprintf(buffer, "0x%04x", address);
+
+    return buffer;
+}
+
+/**
+  * Writes out a single record.
+  */
+static void decode_record(const MicroBitTraceRecord &r, uint32_t now)
+{
+    char first[32];
+    char second[32];
+
+    printf("%12.3f ms  ", -(int32_t)(now - r.time) / 1000.0);
+
+    switch (r.type)
+    {
+        case MICROBIT_TRACE_EVENT_FIRED:
+            printf("fired       %-20s value %-5d queued %d\n", source_name(r.a, first), r.b, r.c);
+            break;
+
+        case MICROBIT_TRACE_EVENT_DISPATCHED:
+            printf("dispatched  %-20s value %-5d queued %d\n", source_name(r.a, first), r.b, r.c);
+            break;
+
+        case MICROBIT_TRACE_EVENT_DROPPED:
+            printf("dropped     %-20s value %-5d (%s)\n", source_name(r.a, first), r.b, dropReasons[r.c < 4 ? r.c : 0]);
+            break;
+
+        case MICROBIT_TRACE_FIBER_SWITCH:
+            if (r.c == MICROBIT_TRACE_IDLE)
+            {
+                idleFiber = r.b;
+                idleFiberSeen = true;
+            }
+
+            fiber_name(r.a, first);
+
+            if (r.c == MICROBIT_TRACE_IDLE)
+                printf("switch      %s -> idle\n", first);
+            else
+                printf("switch      %s -> %s (priority %d)\n", first, fiber_name(r.b, second), r.c);
+            break;
+
+        case MICROBIT_TRACE_PANIC:
+            printf("panic       %d\n", r.a);
+            break;
+
+        default:
+            printf("unknown     type %d: %04x %04x %04x\n", r.type, r.a, r.b, r.c);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    char line[256];
+    int traces = 0;
+
+    if (argc > 1 && (in = fopen(argv[1], "r")) == NULL)
+    {
+        fprintf(stderr, "trace-decoder: can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        unsigned records, count, now;
+
+        if (sscanf(line, "trace %x %x %x", &records, &count, &now) != 3)
+            continue;
+
+        uint32_t counts[MICROBIT_TRACE_PANIC + 1] = { 0 };
+        uint32_t drops[4] = { 0 };
+        uint32_t first = 0, last = 0;
+        unsigned decoded = 0;
+
+        fiberCount = 0;
+        idleFiberSeen = false;
+
+        printf("trace %d: %u records, of %u made since power on\n", ++traces, records, count);
+
+        while (fgets(line, sizeof(line), in) != NULL && strncmp(line, "trace end", 9) != 0)
+        {
+            unsigned time, type, a, b, c;
+
+            if (sscanf(line, "%x %x %x %x %x", &time, &type, &a, &b, &c) != 5)
+                continue;
+
+            MicroBitTraceRecord r = { time, (uint16_t) type, (uint16_t) a, (uint16_t) b, (uint16_t) c };
+
+            decode_record(r, now);
+
+            if (decoded++ == 0)
+                first = r.time;
+            last = r.time;
+
+            if (r.type <= MICROBIT_TRACE_PANIC)
+                counts[r.type]++;
+
+            if (r.type == MICROBIT_TRACE_EVENT_DROPPED)
+                drops[r.c < 4 ? r.c : 0]++;
+        }
+
+        printf("\n%u records over %.3f ms: %u fired, %u dispatched, %u dropped, %u fiber switches between %d fibers (and idle)\n",
+            decoded, (last - first) / 1000.0, counts[MICROBIT_TRACE_EVENT_FIRED], counts[MICROBIT_TRACE_EVENT_DISPATCHED],
+            counts[MICROBIT_TRACE_EVENT_DROPPED], counts[MICROBIT_TRACE_FIBER_SWITCH], fiberCount);
+
+        for (int i = 1; i < 4; i++)
+            if (drops[i])
+                printf("  %u dropped: %s\n", drops[i], dropReasons[i]);
+
+        if (decoded != records)
+            printf("warning: expected %u records, the capture may be truncated\n", records);
+
+        printf("\n");
+    }
+
+    if (traces == 0)
+        fprintf(stderr, "trace-decoder: no trace found\n");
+
+    return traces ? 0 : 1;
+}
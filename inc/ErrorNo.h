@@ -49,5 +49,8 @@ enum PanicCode{
 
     // Dereference of a NULL pointer through the ManagedType class,
     MICROBIT_NULL_DEREFERENCE = 40,
+
+    // A fiber has overflowed its dedicated stack.
+    MICROBIT_FIBER_STACK_OVERFLOW = 50,
 };
 #endif
@@ -28,9 +28,9 @@ class ManagedString
 {
     // StringData contains the reference count, the length, follwed by char[] data, all in one block.
     // When referece count is 0xffff, then it's read only and should not be counted.
-    // Otherwise the block was malloc()ed.
+    // Otherwise the block was malloc()ed, and may be relocatable (see MICROBIT_HEAP_RELOCATABLE).
     // We control access to this to proide immutability and reference counting.
-    StringData *ptr;
+    RefCountedPtr<StringData> ptr;
 
     public:
 
@@ -51,6 +51,7 @@ class ManagedString
     /**
       * Get current ptr, do not decr() it, and set the current instance to empty string.
       * This is to be used by specialized runtimes which pass StringData around.
+      * The data is pinned in the heap, so the pointer returned remains valid until the data is freed.
       */
     StringData *leakData();
 
@@ -281,6 +282,8 @@ class ManagedString
 
     /**
       * Provides an immutable 8 bit wide character buffer representing this string.
+      * If MICROBIT_HEAP_RELOCATABLE is enabled, the buffer may move once the calling fiber blocks, so the pointer
+      * should not be kept beyond that point.
       *
       * @return a pointer to the character buffer.
       */    
@@ -19,8 +19,15 @@ class MemberFunctionCallback
     private:
     void* object;
     uint32_t method[4];
-    void (*invoke)(void *object, uint32_t *method, MicroBitEvent e);
+
+    union
+    {
+        void (*invoke)(void *object, uint32_t *method, MicroBitEvent e);
+        void (*invokeBatch)(void *object, uint32_t *method, MicroBitEvent *e, int count);
+    };
+
     template <typename T> static void methodCall(void* object, uint32_t*method, MicroBitEvent e);
+    template <typename T> static void batchMethodCall(void* object, uint32_t*method, MicroBitEvent *e, int count);
 
     public:
 
@@ -31,6 +38,13 @@ class MemberFunctionCallback
      */
     template <typename T> MemberFunctionCallback(T* object, void (T::*method)(MicroBitEvent e));
 
+    /**
+     * Constructor. Creates a MemberFunctionCallback based on a pointer to given method, that takes a batch of events.
+     * @param object The object the callback method should be invooked on.
+     * @param method The method to invoke.
+     */
+    template <typename T> MemberFunctionCallback(T* object, void (T::*method)(MicroBitEvent *e, int count));
+
     /**
      * Comparison of two MemberFunctionCallback objects.
      * @return TRUE if the given MemberFunctionCallback is equivalent to this one. FALSE otherwise.
@@ -42,6 +56,13 @@ class MemberFunctionCallback
      * @param e The event to deliver to the method
      */
     void fire(MicroBitEvent e);
+
+    /**
+     * Calls the method reference held by this MemberFunctionCallback, which must take a batch of events.
+     * @param e The events to deliver to the method
+     * @param count The number of events
+     */
+    void fire(MicroBitEvent *e, int count);
 };
 
 /**
@@ -58,6 +79,20 @@ MemberFunctionCallback::MemberFunctionCallback(T* object, void (T::*method)(Micr
     invoke = &MemberFunctionCallback::methodCall<T>;
 }
 
+/**
+ * Constructor. Creates a representation of a pointer to a C++ member function (method) that takes a batch of events.
+ * @param object The object the callback method should be invooked on.
+ * @param method The method to invoke.
+ */
+template <typename T>
+MemberFunctionCallback::MemberFunctionCallback(T* object, void (T::*method)(MicroBitEvent *e, int count))
+{
+    this->object = object;
+    memclr(this->method, sizeof(this->method));
+    memcpy(this->method, &method, sizeof(method));
+    invokeBatch = &MemberFunctionCallback::batchMethodCall<T>;
+}
+
 /**
   * Template to create static methods capable of invoking a C++ member function (method)
   * based on the given paramters.
@@ -72,6 +107,20 @@ void MemberFunctionCallback::methodCall(void *object, uint32_t *method, MicroBit
     (o->*m)(e);
 }
 
+/**
+  * Template to create static methods capable of invoking a C++ member function (method)
+  * that takes a batch of events, based on the given paramters.
+  */
+template <typename T>
+void MemberFunctionCallback::batchMethodCall(void *object, uint32_t *method, MicroBitEvent *e, int count)
+{
+    T* o = (T*)object;
+    void (T::*m)(MicroBitEvent *, int);
+    memcpy(&m, method, sizeof(m));
+
+    (o->*m)(e, count);
+}
+
 #endif
 
 
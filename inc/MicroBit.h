@@ -6,6 +6,7 @@
 #include "MicroBitConfig.h"
 #include "MicroBitHeapAllocator.h"
 #include "MicroBitPanic.h"
+#include "MicroBitTrace.h"
 #include "ErrorNo.h"
 #include "Matrix4.h"
 #include "MicroBitCompat.h"
@@ -42,6 +43,7 @@
 #define MICROBIT_FLAG_ACCELEROMETER_RUNNING     0x00000002
 #define MICROBIT_FLAG_DISPLAY_RUNNING           0x00000004
 #define MICROBIT_FLAG_COMPASS_RUNNING           0x00000008
+#define MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED     0x00000010
 
 // MicroBit naming constants
 #define MICROBIT_NAME_LENGTH                    5
@@ -72,6 +74,30 @@ class MicroBit
     //the current tick period in MS
     int                     tickPeriod;
 
+    // State of the system tick, used to keep the system time accurate when the tick is suspended (tickless idle).
+    uint32_t                tickStartedAt;      // The time the periodic system tick was last started (microseconds).
+    uint32_t                tickLag;            // How far the system time lagged behind real time at that point (microseconds).
+    uint32_t                tickSuspendedAt;    // The time at which the system time was exact, when the system tick was suspended.
+
+    /**
+      * Starts the periodic system tick.
+      * @param lag How far the system time lags behind real time, in microseconds.
+      */
+    void startSystemTick(uint32_t lag);
+
+    /**
+      * Determines how far the system time currently lags behind real time (as it is only updated once per tick).
+      * @return The lag, in microseconds.
+      */
+    uint32_t systemTickLag();
+
+    /**
+      * Ends a suspension of the system tick, from the single tick scheduled in its place.
+      * Advances the system time by the tick periods that have elapsed since the tick was suspended
+      * (less the current one, which scheduler_tick() accounts for), and restarts the periodic system tick.
+      */
+    void restartSystemTick();
+
     public:
 
     // Map of device state.
@@ -266,6 +292,23 @@ class MicroBit
       */
     int removeIdleComponent(MicroBitComponent *component);
 
+    /**
+      * Suspends the periodic system tick while the processor is idle, if nothing needs it for a while (tickless idle).
+      * A single system tick is instead scheduled for when a sleeping fiber is next due to be woken up, or a component
+      * next needs a tick (see MicroBitComponent::systemTickPeriod()), whichever is sooner.
+      * Called by the idle task just before the processor sleeps, and followed by resumeSystemTick() when it wakes.
+      *
+      * @return MICROBIT_OK if the system tick was suspended, or MICROBIT_BUSY if a tick is needed within the next two tick periods anyway.
+      */
+    int suspendSystemTick();
+
+    /**
+      * Brings the system time up to date after suspendSystemTick(), once the processor wakes up, and brings
+      * the scheduled system tick forward to the next tick period boundary. That tick restarts the periodic system tick.
+      * Does nothing if the system tick is not suspended.
+      */
+    void resumeSystemTick();
+
 
     /*
      * Reconfigures the ticker to the given speed in milliseconds.
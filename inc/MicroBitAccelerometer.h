@@ -310,6 +310,12 @@ class MicroBitAccelerometer : public MicroBitComponent
      */
     virtual int isIdleCallbackNeeded();
 
+    /**
+     * Determines how long the accelerometer can go without being polled while the processor is idle.
+     * @return The sample period, in milliseconds.
+     */
+    virtual unsigned long systemTickPeriod();
+
     /**
       * Destructor for MicroBitButton, so that we deregister ourselves as an idleComponent
       */
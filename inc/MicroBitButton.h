@@ -31,6 +31,12 @@
 #define MICROBIT_BUTTON_SIGMA_THRESH_LO         2
 #define MICROBIT_BUTTON_DOUBLE_CLICK_THRESH     50
 
+// The longest time a released button is left unsampled while the processor is idle (tickless idle), in milliseconds.
+// Once a press is seen, the button is sampled every system tick again.
+#ifndef MICROBIT_BUTTON_IDLE_SAMPLE_PERIOD
+#define MICROBIT_BUTTON_IDLE_SAMPLE_PERIOD      30
+#endif
+
 enum MicroBitButtonEventConfiguration
 {
     MICROBIT_BUTTON_SIMPLE_EVENTS,
@@ -96,6 +102,13 @@ class MicroBitButton : public MicroBitComponent
       */
     virtual void systemTick();
 
+    /**
+      * Determines how long this button can go without a system tick while the processor is idle.
+      * A released button need only be sampled occasionally, but it is debounced on every tick once it is pressed.
+      * @return The time in milliseconds, or 0 if the button needs every system tick.
+      */
+    virtual unsigned long systemTickPeriod();
+
     /**
       * Destructor for MicroBitButton, so that we deregister ourselves as a systemComponent
       */
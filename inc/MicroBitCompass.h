@@ -328,6 +328,12 @@ class MicroBitCompass : public MicroBitComponent
       */
     virtual int isIdleCallbackNeeded();
 
+    /**
+      * Determines how long the compass can go without being polled while the processor is idle.
+      * @return The sample period, in milliseconds.
+      */
+    virtual unsigned long systemTickPeriod();
+
     /**
       * Destructor for MicroBitCompass, so that we deregister ourselves as an idleComponent
       */
@@ -50,6 +50,9 @@
 #define MICROBIT_ID_NOTIFY              1023          // Notfication channel, for general purpose synchronisation
 #define MICROBIT_ID_NOTIFY_ONE          1022          // Notfication channel, for general purpose synchronisation
 
+// Returned by systemTickPeriod() for components that don't need any system ticks while the processor is idle.
+#define MICROBIT_TICK_PERIOD_UNLIMITED  0xFFFFFFFF
+
 class MicroBitComponent
 {
     protected:
@@ -95,6 +98,19 @@ class MicroBitComponent
         return 0;
     }
 
+    /**
+      * Determines how long this component can go without a system tick while the processor is idle.
+      * For components in the systemTickComponents array, this is the longest acceptable gap between calls to systemTick().
+      * For components in the idleThreadComponents array, it is the longest acceptable gap between calls to idleTick().
+      * Used to suspend the periodic system tick when there is nothing to do (see MICROBIT_TICKLESS_IDLE).
+      * @return The time in milliseconds, 0 if the component needs every system tick, or MICROBIT_TICK_PERIOD_UNLIMITED.
+      * @note override this if your component can tolerate longer gaps, so the processor can sleep for longer.
+      */
+    virtual unsigned long systemTickPeriod()
+    {
+        return 0;
+    }
+
     virtual ~MicroBitComponent()
     {
 
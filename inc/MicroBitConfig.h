@@ -42,6 +42,32 @@
 #define MICROBIT_HEAP_SIZE				0.9
 #endif
 
+// Enable this to keep a free list of small blocks in front of the heap for each of a number of size classes.
+// Small allocations are rounded up to a size class, and freed small blocks are kept on the free list of their
+// class for reuse, so allocating and freeing the most common sizes takes constant time. The free lists are
+// returned to the heap if it runs out of space.
+// Set '1' to enable.
+#ifndef MICROBIT_HEAP_SIZE_CLASSES
+#define MICROBIT_HEAP_SIZE_CLASSES      1
+#endif
+
+// Enable this to allocate the payloads of ManagedString and MicroBitImage as relocatable blocks, referred to
+// through a handle. Whenever the processor is idle, relocatable blocks are slid down the heap to gather the
+// free space between them, so that long running programs churning strings and images can still make large
+// allocations. Costs one word per payload for its handle, plus an extra load on each access to a payload.
+// n.b. Pointers returned by ManagedString::toCharArray() and MicroBitImage::getBitmap() are then only valid
+// until the calling fiber next blocks.
+// Set '1' to enable.
+#ifndef MICROBIT_HEAP_RELOCATABLE
+#define MICROBIT_HEAP_RELOCATABLE       0
+#endif
+
+// The number of handles available for relocatable blocks, held in static storage. Once they are all in use,
+// further payloads are allocated as ordinary blocks.
+#ifndef MICROBIT_HEAP_HANDLES
+#define MICROBIT_HEAP_HANDLES           32
+#endif
+
 // if defined, reuse the 8K of SRAM reserved for SoftDevice (Nordic's memory resident BLE stack) as heap memory.
 // The amount of memory reused depends upon whether or not BLE is enabled using MICROBIT_BLE_ENABLED.
 // Set '1' to enable.
@@ -77,6 +103,63 @@
 #define FIBER_TICK_PERIOD_MS            6
 #endif
 
+// Number of fiber priority levels (at least 2). Runnable fibers of a higher priority are always scheduled
+// ahead of those of a lower priority. Each level costs 20 bytes of RAM.
+#ifndef FIBER_PRIORITY_LEVELS
+#define FIBER_PRIORITY_LEVELS           3
+#endif
+
+// Size of the stack given to fibers created with MICROBIT_FIBER_FLAG_DEDICATED_STACK (bytes).
+// Interrupt handlers run on the stack of whichever fiber they interrupt, so this must also leave room for them.
+#ifndef FIBER_DEDICATED_STACK_SIZE
+#define FIBER_DEDICATED_STACK_SIZE      1024
+#endif
+
+// Number of buckets in the index of fibers blocked in fiber_wait_for_event(), hashed on the event they are waiting for.
+// Must be a power of two. Each bucket costs 4 bytes of RAM.
+#ifndef FIBER_WAIT_QUEUE_BUCKETS
+#define FIBER_WAIT_QUEUE_BUCKETS        8
+#endif
+
+// Number of fibers held in reserve for fork on block (when a function run by invoke(), such as an event handler, blocks).
+// Reserved fibers keep a stack buffer large enough for the deepest fork seen so far, so that in steady state a fork
+// on block doesn't touch the heap. Each reserved fiber costs sizeof(Fiber) bytes of RAM, plus its stack buffer.
+#ifndef FIBER_FORK_RESERVE
+#define FIBER_FORK_RESERVE              2
+#endif
+
+// Enable this to release unused fibers held in the fiber pool (and their stack buffers) back to the heap when
+// the heap is exhausted (outside interrupt context), before an allocation falls back to the native heap or fails.
+// See fiber_pool_trim().
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_POOL_TRIM
+#define MICROBIT_FIBER_POOL_TRIM        1
+#endif
+
+// Enable this to suspend the periodic system tick while the processor is idle (tickless idle).
+// Rather than waking every FIBER_TICK_PERIOD_MS, the processor then sleeps until a sleeping fiber is next due,
+// or a system component next needs a tick. Whilst any component needs every tick (e.g. the display is showing
+// an image), the system tick remains periodic.
+// n.b. A released button is then only sampled every MICROBIT_BUTTON_IDLE_SAMPLE_PERIOD, rather than every tick,
+// so a press shorter than that may be missed while the processor is idle.
+// Set '1' to enable.
+#ifndef MICROBIT_TICKLESS_IDLE
+#define MICROBIT_TICKLESS_IDLE          0
+#endif
+
+// The longest time the system tick is suspended for in tickless idle (milliseconds).
+#ifndef MICROBIT_TICKLESS_MAX_PERIOD_MS
+#define MICROBIT_TICKLESS_MAX_PERIOD_MS 60000
+#endif
+
+// Enable this to record scheduler statistics for each fiber: time spent running, number of times scheduled,
+// worst case scheduling latency and deepest stack. See scheduler_fiber_statistics().
+// Costs 28 bytes of RAM per fiber, and a few microseconds per context switch.
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_STATISTICS
+#define MICROBIT_FIBER_STATISTICS       0
+#endif
+
 //
 // Message Bus:
 // Default behaviour for event handlers, if not specified in the listen() call
@@ -92,12 +175,99 @@
 #endif
 
 //
-// Maximum event queue depth. If a queue exceeds this depth, further events will be dropped.
+// Maximum event queue depth of a busy listener. If a queue exceeds this depth, further events will be dropped.
 // Used to prevent message queues growing uncontrollably due to badly behaved user code and causing panic conditions.
+// Individual listeners can be given a different depth, and can drop the oldest events instead, when they are registered
+// (see MESSAGE_BUS_LISTENER_QUEUE_CAPACITY, MESSAGE_BUS_LISTENER_DROP_OLDEST and MESSAGE_BUS_LISTENER_COALESCE).
 //
 #ifndef MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH
 #define MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH        10
 #endif
+
+//
+// Number of buckets in the index of event listeners, hashed on the source ID they listen to.
+// process() then only scans the listeners in one bucket (plus those listening to MICROBIT_ID_ANY) for each event,
+// rather than every listener. Must be a power of two. Each bucket costs 4 bytes of RAM.
+// Set to '0' to hold all listeners on a single list, scanned in full for every event.
+//
+#ifndef MESSAGE_BUS_LISTENER_BUCKETS
+#define MESSAGE_BUS_LISTENER_BUCKETS                16
+#endif
+
+//
+// Capacity of the message bus event queue, a ring buffer of the events waiting to be processed.
+// Once full, further events are dropped (and counted, see MicroBitMessageBus::getDroppedEventCount()).
+// Each event costs 8 bytes of RAM.
+//
+#ifndef MESSAGE_BUS_EVENT_QUEUE_DEPTH
+#define MESSAGE_BUS_EVENT_QUEUE_DEPTH               16
+#endif
+
+//
+// Number of dedicated fibers that deliver queued events to standard listeners. Otherwise events are delivered only
+// when the processor would be idle, so busy fibers can hold them back indefinitely. With event fibers, events wait
+// at most until a fiber of MESSAGE_BUS_EVENT_FIBER_PRIORITY is next scheduled. Enable MESSAGE_BUS_LATENCY_STATISTICS
+// to see how long they wait. Each fiber costs sizeof(Fiber) bytes of RAM, plus its stack whilst it is descheduled.
+// Set '0' to deliver events from the idle task.
+//
+#ifndef MESSAGE_BUS_EVENT_FIBERS
+#define MESSAGE_BUS_EVENT_FIBERS                    0
+#endif
+
+//
+// Priority of the event fibers (see MESSAGE_BUS_EVENT_FIBERS). Event handlers that block continue in a fiber
+// of the same priority.
+//
+#ifndef MESSAGE_BUS_EVENT_FIBER_PRIORITY
+#define MESSAGE_BUS_EVENT_FIBER_PRIORITY            FIBER_PRIORITY_HIGH
+#endif
+
+//
+// Enable this to record latency statistics for the message bus: for each event source, histograms of how long events
+// wait in the queue before they are dispatched, and how long after dispatch each handler completes, along with the
+// deepest the queue has been. See MicroBitMessageBus::getLatencyStatistics().
+// Costs 4 bytes of RAM per event held in a queue, plus sizeof(MicroBitEventLatency) per source tracked.
+// Set '1' to enable.
+//
+#ifndef MESSAGE_BUS_LATENCY_STATISTICS
+#define MESSAGE_BUS_LATENCY_STATISTICS              0
+#endif
+
+//
+// Number of event sources whose latency is tracked individually. Events from any further sources are counted
+// together, under MICROBIT_ID_ANY.
+//
+#ifndef MESSAGE_BUS_LATENCY_SOURCES
+#define MESSAGE_BUS_LATENCY_SOURCES                 8
+#endif
+
+//
+// Layout of the latency histograms: bucket n counts latencies below (MESSAGE_BUS_LATENCY_RESOLUTION_US << n)
+// microseconds, and the last bucket counts all longer latencies.
+//
+#ifndef MESSAGE_BUS_LATENCY_BUCKETS
+#define MESSAGE_BUS_LATENCY_BUCKETS                 8
+#endif
+
+#ifndef MESSAGE_BUS_LATENCY_RESOLUTION_US
+#define MESSAGE_BUS_LATENCY_RESOLUTION_US           250
+#endif
+
+//
+// Number of MicroBitEventQueueItems held in a static pool, so that queueing an event on a busy listener doesn't
+// touch the heap. Should the pool run dry, further items are allocated from the heap. Each item costs 12 bytes of RAM.
+//
+#ifndef MESSAGE_BUS_EVENT_QUEUE_POOL_SIZE
+#define MESSAGE_BUS_EVENT_QUEUE_POOL_SIZE           10
+#endif
+
+//
+// Number of MicroBitListeners held in a static pool, so that registering an event handler doesn't touch the heap.
+// Should the pool run dry, further listeners are allocated from the heap. Each listener costs 32 bytes of RAM.
+//
+#ifndef MESSAGE_BUS_LISTENER_POOL_SIZE
+#define MESSAGE_BUS_LISTENER_POOL_SIZE              12
+#endif
 //
 // Core micro:bit services
 //
@@ -323,6 +493,33 @@
 #define MICROBIT_HEAP_DBG       0
 #endif
 
+// Enable this to keep a trace of the most recent events fired, dispatched and dropped by the message bus, and of
+// fiber switches, in a ring buffer. The trace is written to the serial port by microbit_trace_dump(), and on panic.
+// Costs a few cycles per record, and 12 bytes of RAM per record held.
+// Set '1' to enable.
+#ifndef MICROBIT_TRACE
+#define MICROBIT_TRACE          0
+#endif
+
+// Number of records held in the trace, after which the oldest are overwritten. Must be a power of two.
+#ifndef MICROBIT_TRACE_RECORDS
+#define MICROBIT_TRACE_RECORDS  64
+#endif
+
+// Enable this to profile the heap by allocation site. Each allocation is tagged with the address it was made
+// from, and the allocations made and memory still held are counted for each site. The sites holding the most
+// memory are written to the serial port by microbit_heap_profile_dump(), and on running out of memory.
+// Costs a search of the site table on each allocation, and 24 bytes of RAM per site. Heaps must be under 256KB.
+// Set '1' to enable.
+#ifndef MICROBIT_HEAP_PROFILE
+#define MICROBIT_HEAP_PROFILE   0
+#endif
+
+// Number of allocation sites profiled, at most 255. Allocations from further sites are counted together as site 0.
+#ifndef MICROBIT_HEAP_PROFILE_SITES
+#define MICROBIT_HEAP_PROFILE_SITES 32
+#endif
+
 // Versioning options.
 // We use semantic versioning (http://semver.org/) to identify differnet versions of the micro:bit runtime.
 // Where possible we use yotta (an ARM mbed build tool) to help us track versions.
@@ -87,6 +87,12 @@ struct MatrixPoint {
     uint8_t y;
 };
 
+/**
+  * Event handler for MICROBIT_DISPLAY_EVT_LIGHT_SENSE, that forwards it to uBit.display.
+  * Called through the static listener table of the device (see microbit_static_listeners).
+  */
+void onDisplayLightSenseEvent(MicroBitEvent evt);
+
 /**
   * Class definition for a MicroBitDisplay.
   *
@@ -264,6 +270,13 @@ public:
       */
     virtual void systemTick();
 
+    /**
+      * Determines how long the display can go without a system tick while the processor is idle.
+      * The display needs every tick whilst it is showing anything, or running an animation.
+      * @return 0 if the display needs every system tick, or MICROBIT_TICK_PERIOD_UNLIMITED otherwise.
+      */
+    virtual unsigned long systemTickPeriod();
+
     /**
      * Prints the given character to the display, if it is not in use.
      *
@@ -590,6 +603,13 @@ public:
       */
     int readLightLevel();
 
+    /**
+      * Event handler for MICROBIT_DISPLAY_EVT_LIGHT_SENSE, which the display raises when it is ready for the light
+      * sensor to take a reading. Starts the light sensor sensing, if it is in use.
+      * Called through onDisplayLightSenseEvent().
+      */
+    void onLightSenseEvent(MicroBitEvent evt);
+
     /**
       * Destructor for MicroBitDisplay, so that we deregister ourselves as a systemComponent
       */
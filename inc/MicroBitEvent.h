@@ -2,12 +2,15 @@
 #define MICROBIT_EVENT_H
 
 #include "mbed.h"
+#include "MicroBitConfig.h"
+#include "MicroBitPool.h"
 
 enum MicroBitEventLaunchMode
 {
     CREATE_ONLY,                        
     CREATE_AND_QUEUE,
-    CREATE_AND_FIRE
+    CREATE_AND_FIRE,
+    CREATE_AND_COALESCE
 };
 
 #define MICROBIT_EVENT_DEFAULT_LAUNCH_MODE     CREATE_AND_QUEUE
@@ -26,6 +29,9 @@ class MicroBitEvent
     uint16_t source;         // ID of the MicroBit Component that generated the event e.g. MICROBIT_ID_BUTTON_A. 
     uint16_t value;          // Component specific code indicating the cause of the event.
     uint32_t timestamp;      // Time at which the event was generated. ms since power on.
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    uint32_t latencyFrom;    // Time at which the event was queued, or once dispatched, the time it was dispatched (us).
+#endif
 
     /**
       * Constructor. 
@@ -36,6 +42,9 @@ class MicroBitEvent
       * CREATE_ONLY: MicroBitEvent is initialised, and no further processing takes place.
       * CREATE_AND_QUEUE: MicroBitEvent is initialised, and queued on the MicroBitMessageBus.
       * CREATE_AND_FIRE: MicroBitEvent is initialised, and its event handlers are immediately fired (not suitable for use in interrupts!).
+      * CREATE_AND_COALESCE: MicroBitEvent is initialised, and queued on the MicroBitMessageBus in place of any event with the
+      * same source and value still waiting to be processed. Suits events that report a new sample is available, where
+      * only the latest matters.
       * 
       * Example: Create and launch an event using the default configuration
       * @code 
@@ -81,7 +90,20 @@ struct MicroBitEventQueueItem
       * @param evt The event that is to be queued.
       */
     MicroBitEventQueueItem(MicroBitEvent evt);
+
+    /**
+      * Allocates memory for a MicroBitEventQueueItem from eventQueueItemPool, or the heap should the pool be empty.
+      */
+    static void *operator new(size_t size);
+
+    /**
+      * Releases the memory of a MicroBitEventQueueItem back to wherever it was allocated from.
+      */
+    static void operator delete(void *ptr);
 };
 
+// The pool that MicroBitEventQueueItems are allocated from (see MESSAGE_BUS_EVENT_QUEUE_POOL_SIZE).
+extern MicroBitPool eventQueueItemPool;
+
 #endif
 
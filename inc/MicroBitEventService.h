@@ -3,6 +3,17 @@
 
 #include "MicroBitEvent.h"
 
+// The most events packed into a single notification of the MicroBitEvent characteristic.
+// 5 events fill the 20 bytes available to a notification.
+#define MICROBIT_EVENT_SERVICE_MAX_EVENTS       5
+
+// A client writes this requirement to the ClientRequirements characteristic (with a reason of
+// MICROBIT_EVENT_SERVICE_PACKED) to receive up to MICROBIT_EVENT_SERVICE_MAX_EVENTS events in each notification
+// of the MicroBitEvent characteristic, as a 4-20 byte value. Otherwise, each event is notified on its own as a
+// single 4 byte EventServiceEvent, as existing clients expect. Lasts until the client disconnects.
+#define MICROBIT_EVENT_SERVICE_ID_OPTIONS       0xFFFF
+#define MICROBIT_EVENT_SERVICE_PACKED           0x0001
+
 // UUIDs for our service and characteristics
 extern const uint8_t  MicroBitEventServiceUUID[];
 extern const uint8_t  MicroBitEventServiceMicroBitEventCharacteristicUUID[]; 
@@ -38,15 +49,22 @@ class MicroBitEventService : public MicroBitComponent
      */  
     virtual void idleTick();    
 
+    /**
+     * Disconnection is signalled by the BLE stack, which wakes the processor anyway,
+     * so no system ticks are needed while the processor is idle.
+     */
+    virtual unsigned long systemTickPeriod();
+
     /**
       * Callback. Invoked when any of our attributes are written via BLE.
       */
     void onDataWritten(const GattWriteCallbackParams *params);
     
     /**
-      * Callback. Invoked when any events are sent on the microBit message bus.
+      * Callback. Invoked with the events sent on the microBit message bus since the last call, which
+      * are packed into as few notifications as possible if the client has asked for MICROBIT_EVENT_SERVICE_PACKED.
       */
-    void onMicroBitEvent(MicroBitEvent evt);
+    void onMicroBitEvent(MicroBitEvent *evt, int count);
 
     /**
      * read callback on microBitRequirements characteristic.
@@ -61,7 +79,7 @@ class MicroBitEventService : public MicroBitComponent
 
     // memory for our event characteristics.
     EventServiceEvent   clientEventBuffer;
-    EventServiceEvent   microBitEventBuffer;
+    EventServiceEvent   microBitEventBuffer[MICROBIT_EVENT_SERVICE_MAX_EVENTS];
     EventServiceEvent   microBitRequirementsBuffer;
     EventServiceEvent   clientRequirementsBuffer;
 
@@ -74,6 +92,9 @@ class MicroBitEventService : public MicroBitComponent
     // Message bus offset last sent to the client...
     uint16_t messageBusListenerOffset;
 
+    // Set if the connected client accepts several events in each notification (see MICROBIT_EVENT_SERVICE_PACKED).
+    bool packedEvents;
+
 };
 
 
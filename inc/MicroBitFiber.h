@@ -14,8 +14,10 @@
 #include "MicroBitConfig.h"
 #include "MicroBitEvent.h"
 
-// TODO: Consider a split mode scheduler, that monitors used stack size, and maintains a dedicated, persistent
-// stack for any long lived fibers with large stack
+// By default, all fibers share the system stack, and the stack of each fiber is paged out to a heap buffer when it
+// is descheduled. This is very RAM efficient, but the cost of a context switch grows with the depth of the stack.
+// Long lived fibers with large stacks can instead be given a dedicated, persistent stack when they are created
+// (MICROBIT_FIBER_FLAG_DEDICATED_STACK), in which case a context switch does not copy any stack at all.
 
 // Fiber Scheduler Flags
 #define MICROBIT_FLAG_DATA_READY 	        0x01 
@@ -25,6 +27,18 @@
 #define MICROBIT_FIBER_FLAG_PARENT          0x02 
 #define MICROBIT_FIBER_FLAG_CHILD           0x04 
 #define MICROBIT_FIBER_FLAG_DO_NOT_PAGE     0x08
+#define MICROBIT_FIBER_FLAG_DEDICATED_STACK 0x10
+
+// Fiber creation option: sets the priority of the new fiber, which is otherwise FIBER_PRIORITY_NORMAL.
+#define MICROBIT_FIBER_FLAG_PRIORITY(p)     (0x100 | ((p) << 9))
+
+// Fiber priorities. Levels are numbered from 0 (the lowest) to FIBER_PRIORITY_LEVELS - 1 (the highest).
+#define FIBER_PRIORITY_LOW                  0
+#define FIBER_PRIORITY_NORMAL               1
+#define FIBER_PRIORITY_HIGH                 (FIBER_PRIORITY_LEVELS - 1)
+
+// Written to the lowest word of a dedicated fiber stack, to detect overflows.
+#define MICROBIT_FIBER_STACK_CANARY         0xDEADF1BE
 
 /**
   *  Thread Context for an ARM Cortex M0 core.
@@ -53,6 +67,21 @@ struct Cortex_M0_TCB
     uint32_t stack_base;                
 };
 
+/**
+  * Scheduler statistics for a single fiber. Only recorded if MICROBIT_FIBER_STATISTICS is enabled.
+  * Times are measured in microseconds, using the same clock as the mbed Ticker (us_ticker_read()).
+  */
+struct FiberStatistics
+{
+    uint32_t entry;                     // The entry function the fiber was created with, or 0 if it has none (e.g. a fiber forked by invoke()).
+    uint32_t runTime;                   // The total time the fiber has spent running.
+    uint32_t switches;                  // The number of times the fiber has been scheduled in.
+    uint32_t maxLatency;                // The longest time the fiber has spent runnable, before it was scheduled in.
+    uint32_t maxStackDepth;             // The deepest stack the fiber has been scheduled out with (bytes).
+    uint32_t runnableAt;                // The time the fiber was last made runnable.
+    uint32_t scheduledAt;               // The time the fiber was last scheduled in.
+};
+
 /**
   * Representation of a single Fiber
   */
@@ -63,9 +92,48 @@ struct Fiber
     uint32_t stack_bottom;              // The start sddress of this Fiber's stack. Stack is heap allocated, and full descending.
     uint32_t stack_top;                 // The end address of this Fiber's stack.
     uint32_t context;                   // Context specific information. 
+    uint32_t order;                     // The order in which this fiber started waiting for an event.
     uint32_t flags;                     // Information about this fiber.
+    uint8_t priority;                   // The priority of this fiber.
     Fiber **queue;                      // The queue this fiber is stored on.
-    Fiber *next, *prev;                 // Position of this Fiber on the run queues.
+    Fiber *next, *prev;                 // Position of this Fiber on the run queues. The prev field of the head refers to the tail.
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    FiberStatistics statistics;         // Scheduler statistics for this fiber.
+#endif
+};
+
+/**
+  * Scheduler statistics for a single priority level. Used to detect the starvation of lower priority fibers.
+  */
+struct FiberPriorityStatistics
+{
+    uint32_t scheduled;                 // The number of times a fiber of this priority has been scheduled.
+    uint32_t starvedTicks;              // The number of system ticks at which fibers of this priority were runnable, but none had run since the previous tick.
+    uint32_t maxStarvedTicks;           // The longest run of consecutive starved ticks.
+    uint32_t currentStarvedTicks;       // The current run of consecutive starved ticks.
+};
+
+/**
+  * Statistics for the fiber pool, and the heap memory held by fibers.
+  * Memory sizes are in bytes, and exclude the overhead of the heap allocator.
+  */
+struct FiberPoolStatistics
+{
+    uint32_t fibers;                    // The number of fibers allocated from the heap, whether in use or held in the fiber pool.
+    uint32_t active;                    // The number of fibers in use (including the idle fiber).
+    uint32_t maxActive;                 // The most fibers in use at once.
+    uint32_t pooled;                    // The number of unused fibers held in the fiber pool.
+    uint32_t pooledBytes;               // The memory held by the fiber pool, including the stack buffers of pooled fibers.
+    uint32_t stackBytes;                // The memory held by the stack buffers of all fibers.
+    uint32_t maxStackBytes;             // The most memory held by stack buffers at once.
+    uint32_t trims;                     // The number of times fiber_pool_trim() or fiber_stack_trim() has released memory.
+    uint32_t trimmedBytes;              // The total memory released by fiber_pool_trim() and fiber_stack_trim().
+    uint32_t reserved;                  // The number of fibers held in the fork on block reserve (see FIBER_FORK_RESERVE).
+    uint32_t reservedBytes;             // The memory held by the fork on block reserve, including stack buffers.
+    uint32_t forkHits;                  // The number of forks on block served from the reserve.
+    uint32_t forkMisses;                // The number of forks on block made when the reserve was empty.
+    uint32_t forkStackGrows;            // The number of forks on block that had to grow the stack buffer of their fiber.
+    uint32_t maxForkStackDepth;         // The deepest stack saved by a fork on block.
 };
 
 extern Fiber *currentFiber;
@@ -105,9 +173,12 @@ void launch_new_fiber_param(void (*ep)(void *), void (*cp)(void *), void *pm)
   *
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param flags MICROBIT_FIBER_FLAG_DEDICATED_STACK to give the fiber a dedicated stack of FIBER_DEDICATED_STACK_SIZE
+  * bytes, rather than paging its stack in and out of the system stack, and/or MICROBIT_FIBER_FLAG_PRIORITY(p)
+  * to set the priority of the fiber (optional).
+  * @return The new Fiber, or NULL if there is insufficient memory available.
   */
-Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = release_fiber);
+Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = release_fiber, uint32_t flags = 0);
 
 
 /**
@@ -116,11 +187,78 @@ Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = releas
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param param an untyped parameter passed into the entry_fn anf completion_fn.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param flags MICROBIT_FIBER_FLAG_DEDICATED_STACK to give the fiber a dedicated stack of FIBER_DEDICATED_STACK_SIZE
+  * bytes, rather than paging its stack in and out of the system stack, and/or MICROBIT_FIBER_FLAG_PRIORITY(p)
+  * to set the priority of the fiber (optional).
+  * @return The new Fiber, or NULL if there is insufficient memory available.
   */
-Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *) = release_fiber);
+Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *) = release_fiber, uint32_t flags = 0);
 
 
+/**
+  * Sets the priority of the currently running fiber.
+  * The new priority takes effect the next time the scheduler runs.
+  *
+  * @param priority The new priority, from FIBER_PRIORITY_LOW to FIBER_PRIORITY_HIGH.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if the priority is out of range.
+  */
+int fiber_set_priority(int priority);
+
+/**
+  * Reads the scheduler statistics for the given priority level.
+  *
+  * @param priority The priority level, from FIBER_PRIORITY_LOW to FIBER_PRIORITY_HIGH.
+  * @param stats The structure to populate.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if the priority is out of range or stats is NULL.
+  */
+int scheduler_priority_statistics(int priority, FiberPriorityStatistics *stats);
+
+/**
+  * Takes a snapshot of the scheduler statistics of every fiber that is running, runnable, sleeping or waiting
+  * for an event (including the idle fiber). Requires MICROBIT_FIBER_STATISTICS to be enabled.
+  *
+  * @param fibers An array to populate with the fibers, or NULL.
+  * @param stats An array to populate with the statistics of each fiber, or NULL.
+  * @param length The length of the arrays.
+  * @return The number of fibers (which may be greater than length), or MICROBIT_NOT_SUPPORTED.
+  */
+int scheduler_fiber_statistics(Fiber **fibers, FiberStatistics *stats, int length);
+
+/**
+  * Writes the scheduler statistics of every fiber to the serial port, one line per fiber.
+  * Requires MICROBIT_FIBER_STATISTICS to be enabled.
+  *
+  * @return MICROBIT_OK, MICROBIT_NO_RESOURCES if there is insufficient memory to take a snapshot, or MICROBIT_NOT_SUPPORTED.
+  */
+int scheduler_fiber_statistics_dump();
+
+/**
+  * Reads the statistics of the fiber pool, including the high-water marks of fibers in use and stack buffer memory.
+  *
+  * @param stats The structure to populate.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if stats is NULL.
+  */
+int fiber_pool_statistics(FiberPoolStatistics *stats);
+
+/**
+  * Releases unused fibers held in the fiber pool, along with their stack buffers, back to the heap.
+  * Fibers are pooled when they complete, so a burst of fibers otherwise holds on to its memory indefinitely.
+  * The fork on block reserve is left intact. Called automatically when the heap is exhausted if MICROBIT_FIBER_POOL_TRIM is enabled.
+  *
+  * @param keep The number of fibers to leave in the pool, to serve future fibers without allocating (defaults to 0).
+  * @return The number of bytes released, or MICROBIT_NOT_SUPPORTED if called from interrupt context.
+  */
+int fiber_pool_trim(int keep = 0);
+
+/**
+  * Shrinks the stack buffers of descheduled fibers that have grown larger than the stack they currently hold
+  * (e.g. after a single deep call), releasing the excess back to the heap. The buffer grows again if needed.
+  * Fibers with a dedicated stack are unaffected.
+  *
+  * @return The number of bytes released, or MICROBIT_NOT_SUPPORTED if called from interrupt context.
+  */
+int fiber_stack_trim();
+
 /**
   * Calls the Fiber scheduler.
   * The calling Fiber will likely be blocked, and control given to another waiting fiber.
@@ -141,12 +279,18 @@ void schedule();
 void fiber_sleep(unsigned long t);
 
 /**
-  * Timer callback. Called from interrupt context, once every FIBER_TICK_PERIOD_MS milliseconds.
+  * Timer callback. Called from interrupt context, once every system tick period (normally FIBER_TICK_PERIOD_MS milliseconds).
   * Simply checks to determine if any fibers blocked on the sleep queue need to be woken up 
   * and made runnable.
   */
 void scheduler_tick();
 
+/**
+  * Determines how long it will be until a sleeping fiber is next due to be woken up.
+  * @return The time in milliseconds (0 if a fiber is already due), or MICROBIT_TICK_PERIOD_UNLIMITED if no fibers are sleeping.
+  */
+unsigned long scheduler_next_wakeup();
+
 /**
   * Blocks the calling thread until the specified event is raised.
   * The calling thread will be immediatley descheduled, and placed onto a 
@@ -160,6 +304,17 @@ void scheduler_tick();
   */
 void fiber_wait_for_event(uint16_t id, uint16_t value);
 
+/**
+  * Makes the longest waiting fiber on the given queue runnable again.
+  * Components that need a wake-up of their own, which user code can neither wait on nor raise (unlike the notify
+  * channels), keep a private queue of their waiting fibers, and move the current fiber onto it before calling schedule().
+  * Safe to call from interrupt context.
+  *
+  * @param queue The queue of waiting fibers.
+  * @return The fiber woken, or NULL if no fiber was waiting.
+  */
+Fiber *fiber_wake_one(Fiber **queue);
+
 /**
   * Executes the given function asynchronously if necessary.
   * 
@@ -198,7 +353,7 @@ int invoke(void (*entry_fn)(void *), void *param);
   * @param f The fiber context to verify.
   * @return The stack depth of the given fiber.
   */
-inline void verify_stack_size(Fiber *f);
+inline uint32_t verify_stack_size(Fiber *f);
 
 /**
   * Event callback. Called from the message bus whenever an event is raised. 
@@ -209,21 +364,29 @@ void scheduler_event(MicroBitEvent evt);
 
 /**
   * Determines if any fibers are waiting to be scheduled.
-  * @return The number of fibers currently on the run queue
+  * @return '1' if there are no fibers on any run queue, and '0' otherwise.
   */
 int scheduler_runqueue_empty();
 
 /**
   * Utility function to add the currenty running fiber to the given queue. 
-  * Perform a simple add at the head, to avoid complexity,
-  * Queues are normally very short, so maintaining a doubly linked, sorted list typically outweighs the cost of
-  * brute force searching.
+  * Queues are doubly linked, and the prev field of the fiber at the head of a queue refers to the tail.
+  * This lets us add at the tail in constant time, without the RAM cost of a separate tail pointer.
   *
   * @param f The fiber to add to the queue
   * @param queue The run queue to add the fiber to.
   */
 void queue_fiber(Fiber *f, Fiber **queue);
 
+/**
+  * Utility function to add the given fiber to the given queue, keeping the queue sorted by the context field
+  * (lowest first). Fibers with equal context are kept in the order they were added.
+  *
+  * @param f The fiber to add to the queue
+  * @param queue The queue to add the fiber to.
+  */
+void queue_fiber_sorted(Fiber *f, Fiber **queue);
+
 /**
   * Utility function to the given fiber from whichever queue it is currently stored on. 
   * @param f the fiber to remove.
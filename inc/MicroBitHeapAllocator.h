@@ -20,13 +20,19 @@
   * P.S. This is a very simple allocator, therefore not without its weaknesses. Why don't you consider 
   * what these are, and consider the tradeoffs against simplicity...
   *
-  * TODO: Consider caching recently freed blocks to improve allocation time.
+  * Recently freed small blocks are cached on free lists, one per size class, in front of the heap
+  * (see MICROBIT_HEAP_SIZE_CLASSES).
+  *
+  * The payloads of ManagedString and MicroBitImage can also be allocated as relocatable blocks, which are
+  * referred to through a handle, and are moved together when the processor is idle to restore large
+  * contiguous free spaces (see MICROBIT_HEAP_RELOCATABLE).
   */
 
 #ifndef MICROBIT_HEAP_ALLOCTOR_H
 #define MICROBIT_HEAP_ALLOCTOR_H
 
 #include "mbed.h"
+#include "MicroBitConfig.h"
 #include <new> 
 
 // The number of heap segments created.
@@ -35,6 +41,42 @@
 // Flag to indicate that a given block is FREE/USED
 #define MICROBIT_HEAP_BLOCK_FREE		0x80000000
 
+// Flags to indicate that a used block may be moved by microbit_heap_compact(), and that a relocatable block
+// has been pinned where it is (see MICROBIT_HEAP_RELOCATABLE).
+#define MICROBIT_HEAP_BLOCK_RELOCATABLE 0x40000000
+#define MICROBIT_HEAP_BLOCK_PINNED      0x20000000
+
+// The allocation site of a used block, held in its index block when profiling the heap (see MICROBIT_HEAP_PROFILE).
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+#define MICROBIT_HEAP_BLOCK_SITE        0x00FF0000
+#else
+#define MICROBIT_HEAP_BLOCK_SITE        0
+#endif
+#define MICROBIT_HEAP_BLOCK_SITE_SHIFT  16
+
+// All of the flags held in the index block of a block. The remaining bits hold the size of the block.
+#define MICROBIT_HEAP_BLOCK_FLAGS       (MICROBIT_HEAP_BLOCK_FREE | MICROBIT_HEAP_BLOCK_RELOCATABLE | MICROBIT_HEAP_BLOCK_PINNED | MICROBIT_HEAP_BLOCK_SITE)
+
+// The number of size classes with a free list in front of the heap (see MICROBIT_HEAP_SIZE_CLASSES).
+#define MICROBIT_HEAP_SIZE_CLASS_COUNT  13
+
+/**
+  * A snapshot of the health of a heap, as reported by microbit_heap_statistics().
+  * All sizes are in bytes, and include the index block of each allocation.
+  */
+struct HeapStatistics
+{
+    uint32_t size;              // The total size of the heap.
+    uint32_t used;              // Memory currently allocated from the heap.
+    uint32_t peakUsed;          // The most memory ever held from the heap at once, including free list blocks.
+    uint32_t totalFree;         // Memory available for allocation, including blocks held on the size class free lists.
+    uint32_t largestFree;       // The largest contiguous free space in the heap, i.e. the largest allocation certain to succeed.
+    uint32_t cached;            // Memory held on the size class free lists, available only to allocations of that size class until flushed.
+    uint32_t fragmentation;     // The percentage of free heap space lying outside the largest free space (0 - 100).
+    uint32_t allocations;       // The number of allocations served from the heap.
+    uint32_t failures;          // The number of allocations the heap did not have space for (which may then have been served elsewhere).
+};
+
 /**
   * Initialise the microbit heap according to the parameters defined in MicroBitConfig.h
   * After this is called, any future calls to malloc, new, free or delete will use the new heap.
@@ -60,6 +102,92 @@ void *microbit_malloc(size_t size);
   */
 void microbit_free(void *mem);
 
+/**
+  * Attempt to allocate a given amount of memory as a relocatable block, which microbit_heap_compact() may move
+  * elsewhere in the heap. The block is referred to through a handle, which always holds its current address
+  * (see microbit_heap_handle()). Requires MICROBIT_HEAP_RELOCATABLE to be enabled: otherwise, or if we run out
+  * of handles or heap space, this is the same as microbit_malloc(). Either way, the memory is released with microbit_free().
+  *
+  * @param size The amount of memory, in bytes, to allocate.
+  * @return A pointer to the allocated memory, or NULL if insufficient memory is available.
+  */
+void *microbit_malloc_relocatable(size_t size);
+
+/**
+  * Determines the handle of a relocatable block.
+  * @param mem The memory allocated, as returned by microbit_malloc_relocatable().
+  * @return The handle of the block, holding its current address, or NULL if the memory is not a relocatable block.
+  */
+void **microbit_heap_handle(void *mem);
+
+/**
+  * Fixes a relocatable block where it is for the rest of its life, so it is safe to refer to it by its address
+  * (e.g. from code outside the runtime). Does nothing to other memory.
+  * @param mem The memory to pin.
+  */
+void microbit_heap_pin(void *mem);
+
+/**
+  * Defragments our heaps, by sliding relocatable blocks down into any free space below them and updating their
+  * handles, so the free space between them gathers into larger contiguous blocks. Pinned and non-relocatable
+  * blocks stay where they are. Does nothing unless memory has been freed since the heaps were last compacted.
+  *
+  * This is called by the scheduler whenever the processor is idle. Any raw pointer into a relocatable block
+  * (e.g. from ManagedString::toCharArray()) held across a call is left dangling, so such pointers must not be
+  * kept by a fiber beyond the point at which it next blocks.
+  *
+  * @return The number of bytes moved, or MICROBIT_NOT_SUPPORTED if MICROBIT_HEAP_RELOCATABLE is not enabled.
+  */
+int microbit_heap_compact();
+
+/**
+  * Reports the health of one of our heaps: how much memory is free, how fragmented that memory is, and
+  * how busy the heap has been. This walks the heap once with interrupts disabled, which costs about the
+  * same as an allocation that has to search the whole heap, so is cheap enough to poll periodically.
+  *
+  * @param index The heap to report on: 0 for the heap nested inside the mbed heap, 1 for the heap
+  * reusing SoftDevice memory.
+  * @param stats The structure to fill in.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if stats is NULL or the given heap does not exist.
+  */
+int microbit_heap_statistics(int index, HeapStatistics *stats);
+
+/**
+  * Writes the allocation sites holding the most memory to the serial port, in the format read by the
+  * heap-profile-decoder host tool, which turns the address of each site into a function and source line:
+  *
+  * @code
+  * heap profile <number of sites written> <number of sites seen> <time profiled (ms)>
+  * <address> <allocations> <live allocations> <live bytes> <peak live bytes> <smallest size> <largest size>
+  * ...
+  * heap profile end
+  * @endcode
+  *
+  * With all numbers in hexadecimal, and sites in order of the memory they hold. Sizes include the index block
+  * of each allocation. Requires MICROBIT_HEAP_PROFILE to be enabled.
+  *
+  * @param sites The most sites to write out.
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_heap_profile_dump(int sites = 10);
+
+/**
+  * Restarts the heap profile: the allocation count, peak and size range of each site are reset, and allocation
+  * rates are measured from now. The memory held by each site is still tracked. Requires MICROBIT_HEAP_PROFILE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_heap_profile_clear();
+
+#ifdef MICROBIT_HEAP_NATIVE_EXTERNAL
+
+// The underlying platform provides its own native heap (e.g. host builds, where the
+// C library heap does not reside in simulated SRAM).
+void *native_malloc(size_t size);
+void native_free(void *p);
+
+#else
+
 /*
  * Wrapper function to ensure we have an explicit handle on the heap allocator provided 
  * by our underlying platform.
@@ -83,18 +211,22 @@ inline void native_free(void *p)
     free(p);
 }
 
+#endif
+
 /**
   * Overrides the 'new' operator globally, and redirects calls to the micro:bit theap allocator.
+  * Always inlined, so the heap profile sees the code creating the object as the allocation site.
   */
-inline void* operator new(size_t size) throw(std::bad_alloc)
+inline __attribute__((always_inline)) void* operator new(size_t size) throw(std::bad_alloc)
 {   
     return microbit_malloc(size);
 }
 
 /**
   * Overrides the 'new' operator globally, and redirects calls to the micro:bit theap allocator.
+  * Always inlined, so the heap profile sees the code creating the object as the allocation site.
   */
-inline void* operator new[](size_t size) throw(std::bad_alloc)
+inline __attribute__((always_inline)) void* operator new[](size_t size) throw(std::bad_alloc)
 {   
     return microbit_malloc(size);
 }
@@ -43,6 +43,11 @@ class MicroBitIOPinService : public MicroBitComponent
      */  
     virtual void idleTick();    
 
+    /**
+     * Pins are polled on every system tick whilst a client is connected, but not otherwise.
+     */
+    virtual unsigned long systemTickPeriod();
+
     private:
 
     /**
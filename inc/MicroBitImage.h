@@ -19,7 +19,7 @@ struct ImageData : RefCounted
   */
 class MicroBitImage
 {
-    ImageData *ptr;     // Pointer to payload data
+    RefCountedPtr<ImageData> ptr;     // Pointer to payload data
     
     
     /**
@@ -42,11 +42,14 @@ class MicroBitImage
     /**
       * Get current ptr, do not decr() it, and set the current instance to empty image.
       * This is to be used by specialized runtimes which pass ImageData around.
+      * The data is pinned in the heap, so the pointer returned remains valid until the data is freed.
       */
     ImageData *leakData();
 
     /**
       * Return a 2D array representing the bitmap image.
+      * If MICROBIT_HEAP_RELOCATABLE is enabled, the bitmap may move once the calling fiber blocks, so the pointer
+      * should not be kept beyond that point.
       */
     uint8_t *getBitmap()
     {
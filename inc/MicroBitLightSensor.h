@@ -51,16 +51,16 @@ class MicroBitLightSensor
       */
     void analogDisable();
 
+    public:
+
     /**
       * The method that is invoked by sending MICROBIT_DISPLAY_EVT_LIGHT_SENSE
-      * using the id MICROBIT_ID_DISPLAY.
+      * using the id MICROBIT_ID_DISPLAY (see MicroBitDisplay::onLightSenseEvent()).
       *
       * If you want to manually trigger this method, you should use the event bus.
       */
     void startSensing(MicroBitEvent);
 
-    public:
-
     /**
       * Constructor.
       * Create a representation of the light sensor
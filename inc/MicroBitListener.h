@@ -4,6 +4,7 @@
 #include "mbed.h"
 #include "MicroBitEvent.h"
 #include "MemberFunctionCallback.h"
+#include "MicroBitPool.h"
 
 // MicroBitListener flags...
 #define MESSAGE_BUS_LISTENER_PARAMETERISED          0x0001
@@ -14,28 +15,103 @@
 #define MESSAGE_BUS_LISTENER_DROP_IF_BUSY           0x0020
 #define MESSAGE_BUS_LISTENER_NONBLOCKING            0x0040
 #define MESSAGE_BUS_LISTENER_URGENT                 0x0080
+#define MESSAGE_BUS_LISTENER_BATCH                  0x0100
+#define MESSAGE_BUS_LISTENER_FILTERED               0x0200
+#define MESSAGE_BUS_LISTENER_VALUE_MASK             0x0400
+#define MESSAGE_BUS_LISTENER_DROP_OLDEST            0x0800
+#define MESSAGE_BUS_LISTENER_COALESCE               0x1000
 #define MESSAGE_BUS_LISTENER_DELETING               0x8000
 
 #define MESSAGE_BUS_LISTENER_IMMEDIATE              (MESSAGE_BUS_LISTENER_NONBLOCKING |  MESSAGE_BUS_LISTENER_URGENT)
 
+// The number of events a busy listener can hold queued, given in the flags passed to listen() (1 - 255).
+// Listeners given no capacity hold up to MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH events.
+#define MESSAGE_BUS_LISTENER_QUEUE_CAPACITY(n)      ((uint32_t)(n) << 16)
+#define MESSAGE_BUS_LISTENER_CAPACITY_OF(flags)     ((flags) >> 16 ? (uint8_t)((flags) >> 16) : MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH)
+
+// Bit representing the given event value in the value mask of a MicroBitEventFilter. Only values 0 - 15 can be represented.
+#define MICROBIT_EVT_MASK(value)                    (1 << (value))
+
+/**
+  * Describes the events a listener is interested in, as a range of source IDs, and either a range of values or
+  * a set of values. Events outside of these are discarded by the message bus, rather than each costing a call
+  * to the handler.
+  *
+  * Example:
+  * @code
+  * // Any event from pins P0 to P2.
+  * MicroBitEventFilter pins(MICROBIT_ID_IO_P0, MICROBIT_ID_IO_P2);
+  *
+  * // Clicks and long clicks of any button.
+  * MicroBitEventFilter buttons(MICROBIT_ID_BUTTON_A, MICROBIT_ID_BUTTON_B);
+  * buttons.valueMask = MICROBIT_EVT_MASK(MICROBIT_BUTTON_EVT_CLICK) | MICROBIT_EVT_MASK(MICROBIT_BUTTON_EVT_LONG_CLICK);
+  * @endcode
+  */
+struct MicroBitEventFilter
+{
+    uint16_t        id;             // The first source ID of interest, or MICROBIT_ID_ANY for all sources.
+    uint16_t        idTo;           // The last source ID of interest.
+    uint16_t        value;          // The first value of interest, or MICROBIT_EVT_ANY for all values.
+    uint16_t        valueTo;        // The last value of interest.
+    uint16_t        valueMask;      // If non-zero, the set of values of interest (see MICROBIT_EVT_MASK), in place of value and valueTo.
+
+    /**
+      * Constructor.
+      * @param id The first source ID of interest, or MICROBIT_ID_ANY for all sources.
+      * @param idTo The last source ID of interest.
+      * @param value The first value of interest (optional), or MICROBIT_EVT_ANY for all values.
+      * @param valueTo The last value of interest (optional).
+      */
+    MicroBitEventFilter(uint16_t id, uint16_t idTo, uint16_t value = 0, uint16_t valueTo = 0)
+    {
+        this->id = id;
+        this->idTo = idTo;
+        this->value = value;
+        this->valueTo = valueTo;
+        this->valueMask = 0;
+    }
+};
+
+
+/**
+  * A listener of a system component that is fixed at compile time. Static listeners are held in a const table,
+  * which lives in flash and costs no RAM. The message bus calls them directly, ahead of any registered listeners,
+  * whenever a matching event is sent, so they behave as MESSAGE_BUS_LISTENER_IMMEDIATE listeners that can never
+  * be removed.
+  *
+  * Each platform defines its table with the components it is composed of (see MicroBit.cpp).
+  */
+struct MicroBitStaticListener
+{
+    uint16_t        id;             // The ID of the component that this listener is interested in, or MICROBIT_ID_ANY.
+    uint16_t        value;          // The value this listener is interested in, or MICROBIT_EVT_ANY.
+    void            (*handler)(MicroBitEvent);  // The function to call. It must not block.
+};
+
 
 struct MicroBitListener
 {
 	uint16_t		id;				// The ID of the component that this listener is interested in. 
 	uint16_t 		value;			// Value this listener is interested in receiving. 
     uint16_t        flags;          // Status and configuration options codes for this listener.
+    uint16_t        idTo;           // The last ID of interest, from id. Set once the listener is added to the message bus.
+    uint16_t        valueTo;        // The last value of interest, from value. Set once the listener is added to the message bus.
+    uint16_t        valueMask;      // The set of values of interest, if MESSAGE_BUS_LISTENER_VALUE_MASK is set.
+    uint8_t         queueLength;    // The number of events queued.
+    uint8_t         queueCapacity;  // The most events that can be queued (see MESSAGE_BUS_LISTENER_QUEUE_CAPACITY).
 
     union 
     {
         void (*cb)(MicroBitEvent);
         void (*cb_param)(MicroBitEvent, void *);
+        void (*cb_batch)(MicroBitEvent *, int);
         MemberFunctionCallback *cb_method;
     };
 
 	void*			cb_arg;			// Optional argument to be passed to the caller. 
 
 	MicroBitEvent 	            evt;
-	MicroBitEventQueueItem 	    *evt_queue;
+	MicroBitEventQueueItem 	    *evt_queue;     // The most recently queued event, which leads on to the oldest, as the queue is circular.
 	
 	MicroBitListener *next;
 
@@ -46,13 +122,19 @@ struct MicroBitListener
 	  * @param value The event ID you would like to listen to from that component
 	  * @param handler A function pointer to call when the event is detected.
 	  */
-	MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 	
 	/**
 	  * Alternative constructor where we register a value to be passed to the
 	  * callback. 
 	  */
-    MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent, void *), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+    MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent, void *), void* arg, uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Alternative constructor for a batched listener, whose handler is given all the matching events
+	  * that have gathered in one call.
+	  */
+    MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent *, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
     /**
      * Constructor. 
@@ -63,7 +145,18 @@ struct MicroBitListener
      * @param object The method within the C++ object to call.
      */
     template <typename T> 
-    MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+    MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+    /**
+     * Constructor.
+     * Create a new batched Message Bus Listener, with a callback to a c++ member function.
+     * @param id The ID of the component you want to listen to.
+     * @param value The event ID you would like to listen to from that component.
+     * @param object The C++ object on which to call the event handler.
+     * @param object The method within the C++ object to call, given the events gathered and their number.
+     */
+    template <typename T>
+    MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent *, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
     /**
       * Destructor. Ensures all resources used by this listener are freed.
@@ -71,12 +164,41 @@ struct MicroBitListener
     ~MicroBitListener();
 
     /**
-     * Queues and event up to be processed.
+     * Restricts this listener to the events described by the given filter, in place of its ID and value.
+     * @param filter The events of interest.
+     */
+    void setFilter(const MicroBitEventFilter &filter);
+
+    /**
+     * Queues and event up to be processed. Should the queue be full, either this event or the oldest is dropped,
+     * depending on MESSAGE_BUS_LISTENER_DROP_OLDEST. With MESSAGE_BUS_LISTENER_COALESCE, an event instead replaces
+     * any queued event with the same source and value.
      * @param e The event to queue
+     * @return The number of events now queued.
      */
-    void queue(MicroBitEvent e);
+    int queue(MicroBitEvent e);
+
+    /**
+     * Removes the oldest event from the queue.
+     * @param e The event to fill in with the oldest event.
+     * @return 1 if an event was dequeued, or 0 if the queue is empty.
+     */
+    int dequeue(MicroBitEvent &e);
+
+    /**
+      * Allocates memory for a MicroBitListener from listenerPool, or the heap should the pool be empty.
+      */
+    static void *operator new(size_t size);
+
+    /**
+      * Releases the memory of a MicroBitListener back to wherever it was allocated from.
+      */
+    static void operator delete(void *ptr);
 };
 
+// The pool that MicroBitListeners are allocated from (see MESSAGE_BUS_LISTENER_POOL_SIZE).
+extern MicroBitPool listenerPool;
+
 /**
   * Constructor. 
   * Create a new Message Bus Listener, with a callback to a c++ member function.
@@ -87,7 +209,7 @@ struct MicroBitListener
   */
 
 template <typename T>
-MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent), uint16_t flags)
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent), uint32_t flags)
 {
 	this->id = id;
 	this->value = value;
@@ -95,6 +217,32 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, T* object, void
 	this->cb_arg = NULL;
     this->flags = flags | MESSAGE_BUS_LISTENER_METHOD;
 	this->next = NULL;
+    this->evt_queue = NULL;
+    this->queueLength = 0;
+    this->queueCapacity = MESSAGE_BUS_LISTENER_CAPACITY_OF(flags);
+}
+
+/**
+  * Constructor.
+  * Create a new batched Message Bus Listener, with a callback to a c++ member function.
+  * @param id The ID of the component you want to listen to.
+  * @param value The event ID you would like to listen to from that component.
+  * @param object The C++ object on which to call the event handler.
+  * @param object The method within the C++ object to call, given the events gathered and their number.
+  */
+
+template <typename T>
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, T* object, void (T::*method)(MicroBitEvent *, int), uint32_t flags)
+{
+	this->id = id;
+	this->value = value;
+    this->cb_method = new MemberFunctionCallback(object, method);
+	this->cb_arg = NULL;
+    this->flags = flags | MESSAGE_BUS_LISTENER_METHOD | MESSAGE_BUS_LISTENER_BATCH;
+	this->next = NULL;
+    this->evt_queue = NULL;
+    this->queueLength = 0;
+    this->queueCapacity = MESSAGE_BUS_LISTENER_CAPACITY_OF(flags);
 }
 
 #endif
@@ -11,6 +11,32 @@
 #define MICROBIT_ID_ANY					0
 #define MICROBIT_EVT_ANY				0
 
+// The listeners of system components that are fixed at compile time, defined by the platform (see MicroBit.cpp).
+extern const MicroBitStaticListener microbit_static_listeners[];
+extern const int microbit_static_listener_count;
+
+// The static listeners of the components common to every platform: the scheduler and the display.
+// Each platform starts its table with these, followed by those of its own components.
+#define MICROBIT_STATIC_LISTENERS_CORE \
+    { MICROBIT_ID_NOTIFY, MICROBIT_EVT_ANY, scheduler_event }, \
+    { MICROBIT_ID_NOTIFY_ONE, MICROBIT_EVT_ANY, scheduler_event }, \
+    { MICROBIT_ID_DISPLAY, MICROBIT_DISPLAY_EVT_LIGHT_SENSE, onDisplayLightSenseEvent }
+
+/**
+  * Latency statistics of the events from a single source. Only recorded if MESSAGE_BUS_LATENCY_STATISTICS is enabled.
+  * Times are measured in microseconds, using the same clock as the mbed Ticker (us_ticker_read()).
+  * Bucket n of each histogram counts latencies below (MESSAGE_BUS_LATENCY_RESOLUTION_US << n), and the last bucket
+  * counts all longer latencies.
+  */
+struct MicroBitEventLatency
+{
+    uint16_t source;                                    // The source of the events, or MICROBIT_ID_ANY for events from untracked sources.
+    uint32_t queued[MESSAGE_BUS_LATENCY_BUCKETS];       // Histogram of the time events spent queued, before they were dispatched.
+    uint32_t handled[MESSAGE_BUS_LATENCY_BUCKETS];      // Histogram of the time from dispatch until each handler of an event completed.
+    uint32_t maxQueued;                                 // The longest time an event spent queued.
+    uint32_t maxHandled;                                // The longest time from dispatch until a handler completed.
+};
+
 /**
   * Class definition for the MicroBitMessageBus.
   *
@@ -56,6 +82,24 @@ class MicroBitMessageBus : public MicroBitComponent
 	  */
 	void send(MicroBitEvent evt);
 
+	/**
+	  * Queues the given event to be sent to all registered recipients, in place of any event with the same
+	  * source and value still waiting to be processed. Urgent listeners still receive every event.
+	  *
+	  * Use this for events that signal a new sample is available, so that if handlers fall behind they are
+	  * given only the latest, and the queue does not fill with stale events.
+	  *
+	  * @param The event to send.
+	  *
+	  * n.b. THIS IS WRAPPED BY THE MicroBitEvent CLASS FOR CONVENIENCE (see CREATE_AND_COALESCE)...
+	  *
+	  * Example:
+      * @code
+	  * MicroBitEvent evt(MICROBIT_ID_ACCELEROMETER, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, CREATE_AND_COALESCE);
+      * @endcode
+	  */
+	void coalesce(MicroBitEvent evt);
+
 	/**
       * Internal function, used to deliver the given event to all relevant recipients.
       * Normally, this is called once an event has been removed from the event queue.
@@ -92,7 +136,7 @@ class MicroBitMessageBus : public MicroBitComponent
       * uBit.MessageBus.listen(MICROBIT_ID_BUTTON_B, MICROBIT_BUTTON_EVT_CLICK, onButtonBClick); // call function when ever a click event is detected.
       * @endcode
 	  */
-	int listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(int id, int value, void (*handler)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
 	/**
 	  * Register a listener function.
@@ -116,7 +160,7 @@ class MicroBitMessageBus : public MicroBitComponent
       * uBit.MessageBus.listen(MICROBIT_ID_BUTTON_B, MICROBIT_BUTTON_EVT_CLICK, onButtonBClick); // call function when ever a click event is detected.
       * @endcode
 	  */
-	int listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
 	/**
 	  * Register a listener function.
@@ -143,7 +187,118 @@ class MicroBitMessageBus : public MicroBitComponent
       * @endcode
 	  */
     template <typename T>
-	int listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a batched listener function. Rather than being called once per event, the handler is given all
+	  * the matching events that have gathered while the event queue was processed, in a single call.
+	  * Events are gathered up to the capacity of the listener's queue, and delivered early should it fill. Each call is
+	  * given at most MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH events.
+	  * Urgent listeners (MESSAGE_BUS_LISTENER_IMMEDIATE) are given each event as a batch of one.
+	  *
+	  * @param id The source of messages to listen for. Events sent from any other IDs will be filtered.
+	  * Use MICROBIT_ID_ANY to receive events from all components.
+	  *
+	  * @param value The value of messages to listen for. Events with any other values will be filtered.
+	  * Use MICROBIT_EVT_ANY to receive events of any value.
+	  *
+	  * @param handler The function to call with the events received, and their number.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  *
+      * Example:
+      * @code
+      * void onButtonEvents(MicroBitEvent *evt, int count)
+      * {
+      * 	//do something with each of evt[0] .. evt[count-1]
+      * }
+      * uBit.MessageBus.listen(MICROBIT_ID_ANY, MICROBIT_EVT_ANY, onButtonEvents);
+      * @endcode
+	  */
+	int listen(int id, int value, void (*handler)(MicroBitEvent*, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a batched listener method (see the batched listen() function above).
+	  *
+	  * @param id The source of messages to listen for. Events sent from any other IDs will be filtered.
+	  * Use MICROBIT_ID_ANY to receive events from all components.
+	  *
+	  * @param value The value of messages to listen for. Events with any other values will be filtered.
+	  * Use MICROBIT_EVT_ANY to receive events of any value.
+	  *
+	  * @param object The object on which the method should be invoked.
+	  * @param handler The method to call with the events received, and their number.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+    template <typename T>
+	int listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent*, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a listener function, for the events described by the given filter: a range of source IDs, and a
+	  * range or set of values. Events outside of these are discarded by the message bus, without calling the handler.
+	  * Filtered listeners are unregistered with ignore(), using the first ID and value of their filter.
+	  *
+	  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+	  * @param handler The function to call when an event is received.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  *
+      * Example:
+      * @code
+      * void onPin(MicroBitEvent evt)
+      * {
+      * 	//do something
+      * }
+      * uBit.MessageBus.listen(MicroBitEventFilter(MICROBIT_ID_IO_P0, MICROBIT_ID_IO_P2), onPin); // call function on any event from pins P0 - P2.
+      * @endcode
+	  */
+	int listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a parameterised listener function, for the events described by the given filter.
+	  *
+	  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+	  * @param handler The function to call when an event is received.
+	  * @param arg An additional argument to pass to the handler.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+	int listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent, void*), void* arg, uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a batched listener function, for the events described by the given filter.
+	  *
+	  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+	  * @param handler The function to call with the events received, and their number.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+	int listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent*, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a listener method, for the events described by the given filter.
+	  *
+	  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+	  * @param object The object on which the method should be invoked.
+	  * @param handler The method to call when an event is received.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+    template <typename T>
+	int listen(const MicroBitEventFilter &filter, T* object, void (T::*handler)(MicroBitEvent), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
+	/**
+	  * Register a batched listener method, for the events described by the given filter.
+	  *
+	  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+	  * @param object The object on which the method should be invoked.
+	  * @param handler The method to call with the events received, and their number.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+    template <typename T>
+	int listen(const MicroBitEventFilter &filter, T* object, void (T::*handler)(MicroBitEvent*, int), uint32_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
 
 	/**
@@ -216,6 +371,32 @@ class MicroBitMessageBus : public MicroBitComponent
     template <typename T>
 	int ignore(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent));
 
+	/**
+	  * Unregister a batched listener function.
+      * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+	  *
+	  * @param id The Event ID used to register the listener.
+	  * @param value The Event VALUE used to register the listener.
+	  * @param handler The function used to register the listener.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+	int ignore(int id, int value, void (*handler)(MicroBitEvent*, int));
+
+	/**
+	  * Unregister a batched listener method.
+      * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+	  *
+	  * @param id The Event ID used to register the listener.
+	  * @param value The Event VALUE used to register the listener.
+	  * @param object The object used to register the listener.
+	  * @param handler The method used to register the listener.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+    template <typename T>
+	int ignore(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent*, int));
+
     /**
       * Returns the microBitListener with the given position in our list.
       * @param n The position in the list to return.
@@ -223,6 +404,59 @@ class MicroBitMessageBus : public MicroBitComponent
       */
     MicroBitListener *elementAt(int n);
 
+    /**
+      * Returns the number of events dropped since power on, because the event queue was full.
+      * @return The number of events dropped.
+      */
+    uint32_t getDroppedEventCount();
+
+    /**
+      * Reads the latency statistics recorded for events from one source. Sources are tracked in the order they
+      * are first seen, at positions 0 to MESSAGE_BUS_LATENCY_SOURCES - 1, and the events from any further sources
+      * are counted at position MESSAGE_BUS_LATENCY_SOURCES.
+      * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+      *
+      * @param n The position of the source, from 0.
+      * @param stats The structure to populate.
+      * @return MICROBIT_OK, MICROBIT_INVALID_PARAMETER if there is no such source or stats is NULL, or MICROBIT_NOT_SUPPORTED.
+      */
+    int getLatencyStatistics(int n, MicroBitEventLatency *stats);
+
+    /**
+      * Returns the greatest number of events that have been waiting in the event queue at once.
+      * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+      *
+      * @return The deepest the event queue has been, or MICROBIT_NOT_SUPPORTED.
+      */
+    int getMaxQueueDepth();
+
+    /**
+      * Clears all latency statistics, and the deepest the event queue has been.
+      * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+      *
+      * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+      */
+    int resetLatencyStatistics();
+
+    /**
+      * Writes the latency statistics of every source to the serial port, as two lines per source: one for the
+      * time events spent queued ('q') and one for the time until handlers completed ('h').
+      * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+      *
+      * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+      */
+    int printLatencyStatistics();
+
+    /**
+      * Starts the fibers that deliver queued events to standard listeners (see MESSAGE_BUS_EVENT_FIBERS), in place of
+      * the idle task. Events are then delivered as soon as an event fiber can be scheduled, rather than only when the
+      * processor would otherwise be idle. Called by MicroBit::init().
+      *
+      * @return MICROBIT_OK, MICROBIT_NO_RESOURCES if no fibers could be created, or MICROBIT_NOT_SUPPORTED if
+      * MESSAGE_BUS_EVENT_FIBERS is 0.
+      */
+    int startEventFibers();
+
     /**
       * Destructor for MicroBitMessageBus, so that we deregister ourselves as an idleComponent
       */
@@ -250,17 +484,56 @@ class MicroBitMessageBus : public MicroBitComponent
      */
     int deleteMarkedListeners();
 
-	MicroBitListener            *listeners;		    // Chain of active listeners.
-    MicroBitEventQueueItem      *evt_queue_head;    // Head of queued events to be processed.
-    MicroBitEventQueueItem      *evt_queue_tail;    // Tail of queued events to be processed.
+    /**
+     * Determines the chain of listeners that holds those listening to the given source ID.
+     * @param id The source ID.
+     * @return The head of the chain.
+     */
+    MicroBitListener **listenerChain(uint16_t id);
+
+    /**
+     * Returns the nth chain of listeners, in order to visit every listener.
+     * @param n The position of the chain.
+     * @return The head of the chain, or NULL if the position is invalid.
+     */
+    MicroBitListener **listenerChainAt(int n);
+
+    /**
+     * Checks that the given filter describes at least one event.
+     * @param filter The filter to check.
+     * @return MICROBIT_OK if the filter is valid, MICROBIT_INVALID_PARAMETER otherwise.
+     */
+    int checkFilter(const MicroBitEventFilter &filter);
+
+    /**
+     * Delivers the events gathered by every batched listener that is not already busy handling a batch.
+     */
+    void dispatchBatches();
+
+	MicroBitListener            *listeners;		    // Chain of listeners to MICROBIT_ID_ANY (or all listeners, if there is no index).
+#if MESSAGE_BUS_LISTENER_BUCKETS > 0
+    MicroBitListener            *listenerIndex[MESSAGE_BUS_LISTENER_BUCKETS];   // Chains of all other listeners, hashed on source ID.
+#endif
+    MicroBitEvent               evt_queue[MESSAGE_BUS_EVENT_QUEUE_DEPTH];  // Ring buffer of events to be processed.
+    volatile uint16_t           queueHead;          // Position in the ring buffer of the next event to be processed.
+    volatile uint16_t           queueTail;          // Position in the ring buffer where the next event will be queued.
+    volatile uint16_t           queueLength;        // The number of events currently waiting to be processed.
     uint16_t                    nonce_val;          // The last nonce issued.
-    uint16_t                    queueLength;        // The number of events currently waiting to be processed.
+    uint32_t                    droppedEvents;      // The number of events dropped as the queue was full.
+    bool                        batchPending;       // Set when batched listeners have gathered events yet to be delivered.
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    uint8_t                     eventFibers;        // The number of event fibers running.
+    Fiber                       *eventFiberQueue;   // The event fibers waiting for an event to be queued.
+#endif
 
-    void queueEvent(MicroBitEvent &evt);
-    MicroBitEventQueueItem* dequeueEvent();
+    void queueEvent(MicroBitEvent &evt, bool coalesce = false);
+    int dequeueEvent(MicroBitEvent &evt);
+    void processQueue(bool yield);
+    static void eventFiber(void *param);
 
     virtual void idleTick();
     virtual int isIdleCallbackNeeded();
+    virtual unsigned long systemTickPeriod();
 };
 
 /**
@@ -279,7 +552,7 @@ class MicroBitMessageBus : public MicroBitComponent
   * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
   */
 template <typename T>
-int MicroBitMessageBus::listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags)
+int MicroBitMessageBus::listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint32_t flags)
 {
 	if (object == NULL || handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
@@ -325,5 +598,110 @@ int MicroBitMessageBus::ignore(uint16_t id, uint16_t value, T* object, void (T::
     return MICROBIT_OK;
 }
 
+/**
+  * A registration function to allow C++ member funcitons (methods) to be registered as a batched event
+  * listener.
+  *
+  * @param id The source of messages to listen for. Events sent from any other IDs will be filtered.
+  * Use MICROBIT_ID_ANY to receive events from all components.
+  *
+  * @param value The value of messages to listen for. Events with any other values will be filtered.
+  * Use MICROBIT_EVT_ANY to receive events of any value.
+  *
+  * @param object The object on which the method should be invoked.
+  * @param handler The method to call with the events received, and their number.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+template <typename T>
+int MicroBitMessageBus::listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent*, int), uint32_t flags)
+{
+	if (object == NULL || handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(id, value, object, handler, flags);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+ * Unregister a batched listener method.
+ * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+ *
+ * @param id The Event ID used to register the listener.
+ * @param value The Event VALUE used to register the listener.
+ * @param object The object used to register the listener.
+ * @param handler The method used to register the listener.
+ *
+ * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+ */
+template <typename T>
+int MicroBitMessageBus::ignore(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent*, int))
+{
+	if (handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener listener(id, value, object, handler);
+    remove(&listener);
+
+    return MICROBIT_OK;
+}
+
+
+/**
+  * A registration function to allow C++ member funcitons (methods) to be registered as an event
+  * listener, for the events described by the given filter.
+  *
+  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+  * @param object The object on which the method should be invoked.
+  * @param handler The method to call when an event is received.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+template <typename T>
+int MicroBitMessageBus::listen(const MicroBitEventFilter &filter, T* object, void (T::*handler)(MicroBitEvent), uint32_t flags)
+{
+	if (object == NULL || handler == NULL || checkFilter(filter) != MICROBIT_OK)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(filter.id, filter.value, object, handler, flags);
+    newListener->setFilter(filter);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+  * A registration function to allow C++ member funcitons (methods) to be registered as a batched event
+  * listener, for the events described by the given filter.
+  *
+  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+  * @param object The object on which the method should be invoked.
+  * @param handler The method to call with the events received, and their number.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+template <typename T>
+int MicroBitMessageBus::listen(const MicroBitEventFilter &filter, T* object, void (T::*handler)(MicroBitEvent*, int), uint32_t flags)
+{
+	if (object == NULL || handler == NULL || checkFilter(filter) != MICROBIT_OK)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(filter.id, filter.value, object, handler, flags);
+    newListener->setFilter(filter);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+    return MICROBIT_NO_RESOURCES;
+}
 
 #endif
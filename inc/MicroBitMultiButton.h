@@ -10,6 +10,12 @@
 #define MICROBIT_MULTI_BUTTON_SUPRESSED_1           0X10 
 #define MICROBIT_MULTI_BUTTON_SUPRESSED_2           0x20
 
+/**
+  * Event handler for the events of buttons A and B, that forwards them to uBit.buttonAB.
+  * Called through the static listener table of the device (see microbit_static_listeners).
+  */
+void onMultiButtonEvent(MicroBitEvent evt);
+
 /**
   * Class definition for MicroBitMultiButton.
   *
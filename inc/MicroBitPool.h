@@ -0,0 +1,54 @@
+#ifndef MICROBIT_POOL_H
+#define MICROBIT_POOL_H
+
+#include "mbed.h"
+
+/**
+  * A fixed size pool of objects of a single type, held in static storage.
+  *
+  * Used for small objects that are created and destroyed at a high rate, such as MicroBitEventQueueItem,
+  * so that they neither cost a heap operation each nor fail due to heap fragmentation. Objects are handed out
+  * from the storage in turn, and recycled through a free list linked through their first word once released.
+  *
+  * A MicroBitPool has no constructor, so it can be statically initialised, and is ready for use before any
+  * static constructors run. Both allocate() and release() are safe to call from interrupt context.
+  *
+  * Example:
+  * @code
+  * static uint32_t storage[MICROBIT_POOL_STORAGE(sizeof(Thing), 8)];
+  * MicroBitPool thingPool = { storage, MICROBIT_POOL_OBJECT_SIZE(sizeof(Thing)), 8 };
+  * @endcode
+  */
+
+// The size of each object held in a pool, rounded up to a whole number of words.
+#define MICROBIT_POOL_OBJECT_SIZE(size)         (((size) + 3) & ~3)
+
+// The number of words of storage needed by a pool of the given capacity.
+#define MICROBIT_POOL_STORAGE(size, capacity)   ((capacity) > 0 ? MICROBIT_POOL_OBJECT_SIZE(size) / 4 * (capacity) : 1)
+
+struct MicroBitPool
+{
+    uint32_t    *storage;       // The memory holding the objects in the pool.
+    uint16_t    objectSize;     // The size of each object (bytes, a multiple of 4).
+    uint16_t    capacity;       // The number of objects the storage can hold.
+    uint16_t    issued;         // The number of objects handed out from the storage so far, in turn.
+    uint16_t    inUse;          // The number of objects currently allocated.
+    uint16_t    maxInUse;       // The most objects ever allocated at once.
+    uint16_t    misses;         // The number of requests made while the pool was empty.
+    void        *freeList;      // Released objects, linked through their first word.
+
+    /**
+      * Allocates an object from the pool.
+      * @return A pointer to memory for the object, or NULL if the pool is empty.
+      */
+    void *allocate();
+
+    /**
+      * Returns an object to the pool, if it was allocated from it.
+      * @param object The object to release.
+      * @return 1 if the object was released into the pool, or 0 if it is not part of the pool.
+      */
+    int release(void *object);
+};
+
+#endif
@@ -143,6 +143,14 @@ class MicroBitRadio : MicroBitComponent
      */
     virtual void idleTick();
 
+    /**
+     * Packets are received by an interrupt handler, which wakes the processor anyway, so the radio
+     * needs no system ticks while the processor is idle.
+     *
+     * @return MICROBIT_TICK_PERIOD_UNLIMITED.
+     */
+    virtual unsigned long systemTickPeriod();
+
     /**
      * Determines the number of packets ready to be processed.
      * @return The number of packets in the receive buffer.
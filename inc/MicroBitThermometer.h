@@ -83,6 +83,12 @@ class MicroBitThermometer : public MicroBitComponent
       */
     virtual int isIdleCallbackNeeded();
 
+    /**
+      * Determines how long the thermometer can go without being serviced while the processor is idle.
+      * @return The time until the next temperature reading is due, in milliseconds.
+      */
+    virtual unsigned long systemTickPeriod();
+
     private:
 
     /**
@@ -0,0 +1,101 @@
+#ifndef MICROBIT_TRACE_H
+#define MICROBIT_TRACE_H
+
+#include "mbed.h"
+#include "MicroBitConfig.h"
+
+/**
+  * Event trace.
+  *
+  * A fixed size ring buffer of the most recent things to happen in the runtime: every event fired, dispatched
+  * from the event queue and dropped by the message bus, and every fiber switch, each with a timestamp. Only
+  * recorded if MICROBIT_TRACE is enabled.
+  *
+  * The trace can be written to the serial port with microbit_trace_dump(), and is also written out if the
+  * micro:bit panics. Either way, it can be turned into a readable timeline with the trace-decoder host tool
+  * (see host/tools/TraceDecoder.cpp).
+  */
+
+// Types of trace record, and what each records in its a, b and c fields.
+#define MICROBIT_TRACE_EVENT_FIRED          1       // An event sent to the message bus. a: source, b: value, c: length of the event queue.
+#define MICROBIT_TRACE_EVENT_DISPATCHED     2       // An event taken from the event queue. a: source, b: value, c: events left in the queue.
+#define MICROBIT_TRACE_EVENT_DROPPED        3       // An event dropped. a: source, b: value, c: the reason (see below).
+#define MICROBIT_TRACE_FIBER_SWITCH         4       // A context switch. a: fiber switched from, b: fiber switched to, c: priority of b.
+#define MICROBIT_TRACE_PANIC                5       // The micro:bit panicked. a: the status code.
+
+// Reasons for MICROBIT_TRACE_EVENT_DROPPED.
+#define MICROBIT_TRACE_DROP_QUEUE_FULL      1       // The event queue of the message bus was full.
+#define MICROBIT_TRACE_DROP_LISTENER_BUSY   2       // A listener with MESSAGE_BUS_LISTENER_DROP_IF_BUSY was busy.
+#define MICROBIT_TRACE_DROP_LISTENER_FULL   3       // The queue of a busy listener was full. With MESSAGE_BUS_LISTENER_DROP_OLDEST, the oldest event is the one dropped.
+
+// Fibers are recorded by the low 16 bits of their address, which is unique within SRAM.
+// The idle fiber is recorded with a priority of MICROBIT_TRACE_IDLE.
+#define MICROBIT_TRACE_FIBER(f)             ((uint16_t)(uintptr_t)(f))
+#define MICROBIT_TRACE_IDLE                 0xFFFF
+
+struct MicroBitTraceRecord
+{
+    uint32_t    time;       // When the record was made (us, from the same clock as the mbed Ticker).
+    uint16_t    type;       // The type of record, one of MICROBIT_TRACE_*.
+    uint16_t    a;          // Fields of the record, dependent upon the type.
+    uint16_t    b;
+    uint16_t    c;
+};
+
+#if CONFIG_ENABLED(MICROBIT_TRACE)
+extern MicroBitTraceRecord microbit_trace_buffer[MICROBIT_TRACE_RECORDS];
+extern uint32_t microbit_trace_count;
+#endif
+
+/**
+  * Adds a record to the trace, overwriting the oldest record once the trace is full.
+  * Safe to call from any context, with interrupts enabled or disabled. Costs nothing unless MICROBIT_TRACE is enabled.
+  *
+  * @param type The type of record, one of MICROBIT_TRACE_*.
+  * @param a The first field of the record.
+  * @param b The second field of the record.
+  * @param c The third field of the record.
+  */
+inline void microbit_trace(uint16_t type, uint16_t a, uint16_t b, uint16_t c)
+{
+#if CONFIG_ENABLED(MICROBIT_TRACE)
+    // Claim a record. Once claimed, the record is ours to fill in, even if we're interrupted.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    MicroBitTraceRecord *r = &microbit_trace_buffer[microbit_trace_count++ & (MICROBIT_TRACE_RECORDS - 1)];
+
+    __set_PRIMASK(primask);
+
+    r->time = us_ticker_read();
+    r->type = type;
+    r->a = a;
+    r->b = b;
+    r->c = c;
+#endif
+}
+
+/**
+  * Writes the trace to the serial port, oldest record first, in the format read by the trace-decoder host tool:
+  *
+  * @code
+  * trace <number of records> <records made since power on> <time now>
+  * <time> <type> <a> <b> <c>
+  * ...
+  * trace end
+  * @endcode
+  *
+  * With all numbers in hexadecimal. Requires MICROBIT_TRACE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_trace_dump();
+
+/**
+  * Discards all records in the trace. Requires MICROBIT_TRACE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_trace_clear();
+
+#endif
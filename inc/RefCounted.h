@@ -2,6 +2,8 @@
 #define REF_COUNTED_H
 
 #include "mbed.h"
+#include "MicroBitConfig.h"
+#include "MicroBitHeapAllocator.h"
 
 /**
   * Base class for payload for ref-counted objects. Used by ManagedString and MicroBitImage.
@@ -31,4 +33,59 @@ public:
     bool isReadOnly();
 };
 
+/**
+  * A reference to a ref-counted payload, as held by ManagedString and MicroBitImage. Used just like a pointer.
+  *
+  * If MICROBIT_HEAP_RELOCATABLE is enabled, payloads allocated by microbit_malloc_relocatable() may be moved by
+  * microbit_heap_compact(), so such payloads are referred to through their handle instead, marked by setting
+  * the lowest bit. Payloads in flash, and any that could not be given a handle, are referred to directly.
+  * There is no constructor, so it can be part of a class that is statically initialised.
+  */
+template <class T>
+class RefCountedPtr
+{
+    T *ptr;
+
+public:
+    /**
+      * Determines the current address of the payload.
+      */
+    T *get() const
+    {
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+        if ((uintptr_t) ptr & 1)
+            return *(T **)((uintptr_t) ptr & ~1);
+#endif
+        return ptr;
+    }
+
+    T *operator->() const
+    {
+        return get();
+    }
+
+    operator T*() const
+    {
+        return get();
+    }
+
+    /**
+      * Refers to the given payload, through its handle if it has one.
+      */
+    RefCountedPtr<T>& operator=(T *p)
+    {
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+        void **handle = microbit_heap_handle(p);
+
+        if (handle != NULL)
+        {
+            ptr = (T *)((uintptr_t) handle | 1);
+            return *this;
+        }
+#endif
+        ptr = p;
+        return *this;
+    }
+};
+
 #endif
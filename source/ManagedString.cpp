@@ -23,7 +23,7 @@ void ManagedString::initString(const char *str)
     // Initialise this ManagedString as a new string, using the data provided.
     // We assume the string is sane, and null terminated.
     int len = strlen(str);
-    ptr = (StringData *) malloc(4+len+1);
+    ptr = (StringData *) microbit_malloc_relocatable(4+len+1);
     ptr->init();
     ptr->len = len;
     memcpy(ptr->data, str, len+1);
@@ -54,6 +54,7 @@ ManagedString::ManagedString(StringData *p)
 StringData* ManagedString::leakData()
 {
     StringData *res = ptr;
+    microbit_heap_pin(res);
     initEmpty();
     return res;
 }
@@ -121,7 +122,7 @@ ManagedString::ManagedString(const ManagedString &s1, const ManagedString &s2)
     int len = s1.length() + s2.length();
 
     // Create a new buffer for holding the new string data.
-    ptr = (StringData*) malloc(4+len+1);
+    ptr = (StringData*) microbit_malloc_relocatable(4+len+1);
     ptr->init();
     ptr->len = len;
 
@@ -157,7 +158,7 @@ ManagedString::ManagedString(const char *str, const int16_t length)
 
     
     // Allocate a new buffer, and create a NULL terminated string.
-    ptr = (StringData*) malloc(4+length+1);
+    ptr = (StringData*) microbit_malloc_relocatable(4+length+1);
     ptr->init();
     // Store the length of the new string
     ptr->len = length;
@@ -20,6 +20,16 @@ void MemberFunctionCallback::fire(MicroBitEvent e)
     invoke(object, method, e);
 }
 
+/**
+  * Calls the method reference held by this MemberFunctionCallback, which must take a batch of events.
+  * @param e The events to deliver to the method
+  * @param count The number of events
+  */
+void MemberFunctionCallback::fire(MicroBitEvent *e, int count)
+{
+    invokeBatch(object, method, e, count);
+}
+
 /**
   * Comparison of two MemberFunctionCallback objects.
   * @return TRUE if the given MemberFunctionCallback is equivalent to this one. FALSE otherwise.
@@ -65,6 +65,19 @@ void bleDisconnectionCallback(const Gap::DisconnectionCallbackParams_t *)
     uBit.ble->startAdvertising();
 }
 
+/**
+  * The listeners of system components that are fixed at compile time. Being const, the table is held in flash,
+  * and the message bus calls these ahead of any registered listener without the RAM, or the scan of the listener
+  * lists, that registering each of them with listen() would cost. Handlers must not block.
+  */
+const MicroBitStaticListener microbit_static_listeners[] = {
+    MICROBIT_STATIC_LISTENERS_CORE,
+    { MICROBIT_ID_BUTTON_A, MICROBIT_EVT_ANY, onMultiButtonEvent },
+    { MICROBIT_ID_BUTTON_B, MICROBIT_EVT_ANY, onMultiButtonEvent }
+};
+
+extern const int microbit_static_listener_count = sizeof(microbit_static_listeners) / sizeof(MicroBitStaticListener);
+
 
 /**
   * Constructor.
@@ -131,13 +144,16 @@ void MicroBit::init()
     addIdleComponent(&uBit.compass);
     addIdleComponent(&uBit.MessageBus);
 
+    // Deliver events from dedicated fibers, if so configured.
+    MessageBus.startEventFibers();
+
     // Seed our random number generator
     seedRandom();
 
     tickPeriod = MICROBIT_DEFAULT_TICK_PERIOD;
 
     // Start refreshing the Matrix Display
-    systemTicker.attach_us(this, &MicroBit::systemTick, tickPeriod * 1000);
+    startSystemTick(0);
 
     // Register our compass calibration algorithm.
     MessageBus.listen(MICROBIT_ID_COMPASS, MICROBIT_COMPASS_EVT_CALIBRATE, this, &MicroBit::compassCalibrator, MESSAGE_BUS_LISTENER_IMMEDIATE);
@@ -497,6 +513,11 @@ void MicroBit::seedRandom(uint32_t seed)
   */
 void MicroBit::systemTick()
 {
+    // If the system tick was suspended, this is the single tick that was scheduled in its place.
+    // Bring the system time up to date (scheduler_tick() accounts for the current tick period, as usual).
+    if (flags & MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED)
+        restartSystemTick();
+
     // Scheduler callback. We do this here just as a single timer is more efficient. :-)
     if (uBit.flags & MICROBIT_FLAG_SCHEDULER_RUNNING)
         scheduler_tick();
@@ -611,35 +632,6 @@ int MicroBit::removeIdleComponent(MicroBitComponent *component)
     return MICROBIT_OK;
 }
 
-/*
- * Reconfigures the ticker to the given speed in milliseconds.
- * @param speedMs the speed in milliseconds
- * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMETER is returned if speedUs < 1
- *
- * @note this will also modify the value that is added to ticks in MiroBitFiber:scheduler_tick()
- */
-int MicroBit::setTickPeriod(int speedMs)
-{
-    if(speedMs < 1)
-        return MICROBIT_INVALID_PARAMETER;
-
-    uBit.systemTicker.detach();
-
-    uBit.systemTicker.attach_us(this, &MicroBit::systemTick, speedMs * 1000);
-
-    tickPeriod = speedMs;
-
-    return MICROBIT_OK;
-}
-
-/*
- * Returns the currently used tick speed in milliseconds
- */
-int MicroBit::getTickPeriod()
-{
-    return tickPeriod;
-}
-
 /**
   * Determine the time since this MicroBit was last reset.
   *
@@ -665,11 +657,15 @@ const char *MicroBit::systemVersion()
 
 /**
   * Triggers a microbit panic where an infinite loop will occur swapping between the panicFace and statusCode if provided.
+  * If MICROBIT_TRACE is enabled, the event trace is first written to the serial port.
   *
   * @param statusCode the status code of the associated error. Status codes must be in the range 0-255.
   */
 void MicroBit::panic(int statusCode)
 {
+    microbit_trace(MICROBIT_TRACE_PANIC, statusCode, 0, 0);
+    microbit_trace_dump();
+
     //show error and enter infinite while
     uBit.display.error(statusCode);
 }
@@ -224,8 +224,8 @@ int MicroBitAccelerometer::update()
     // Update gesture tracking
     updateGesture();
 
-    // Indicate that a new sample is available
-    MicroBitEvent e(id, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE);
+    // Indicate that a new sample is available. Handlers read the latest sample, so only the latest event matters.
+    MicroBitEvent e(id, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, CREATE_AND_COALESCE);
 
     return MICROBIT_OK;
 };
@@ -571,6 +571,15 @@ int MicroBitAccelerometer::isIdleCallbackNeeded()
     return !int1;
 }
 
+/**
+ * Determines how long the accelerometer can go without being polled while the processor is idle.
+ * @return The sample period, in milliseconds.
+ */
+unsigned long MicroBitAccelerometer::systemTickPeriod()
+{
+    return samplePeriod;
+}
+
 /**
   * Destructor for MicroBitAccelerometer, so that we deregister ourselves as an idleComponent
   */
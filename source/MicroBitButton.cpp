@@ -92,6 +92,19 @@ void MicroBitButton::systemTick()
     }
 }
 
+/**
+  * Determines how long this button can go without a system tick while the processor is idle.
+  * A released button need only be sampled occasionally, but it is debounced on every tick once it is pressed.
+  * @return The time in milliseconds, or 0 if the button needs every system tick.
+  */
+unsigned long MicroBitButton::systemTickPeriod()
+{
+    if(sigma == MICROBIT_BUTTON_SIGMA_MIN && !(status & MICROBIT_BUTTON_STATE))
+        return MICROBIT_BUTTON_IDLE_SAMPLE_PERIOD;
+
+    return 0;
+}
+
 /**
   * Tests if this Button is currently pressed.
   * @return 1 if this button is pressed, 0 otherwise.
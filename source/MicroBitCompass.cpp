@@ -187,8 +187,8 @@ void MicroBitCompass::idleTick()
         sample.y = MAG3110_NORMALIZE_SAMPLE((int) read16(MAG_OUT_Y_MSB));
         sample.z = MAG3110_NORMALIZE_SAMPLE((int) read16(MAG_OUT_Z_MSB));
 
-        // Indicate that a new sample is available
-        MicroBitEvent e(id, MICROBIT_COMPASS_EVT_DATA_UPDATE);
+        // Indicate that a new sample is available. Handlers read the latest sample, so only the latest event matters.
+        MicroBitEvent e(id, MICROBIT_COMPASS_EVT_DATA_UPDATE, CREATE_AND_COALESCE);
     }
 }
 
@@ -537,6 +537,15 @@ int MicroBitCompass::isIdleCallbackNeeded()
     return int1;
 }
 
+/**
+  * Determines how long the compass can go without being polled while the processor is idle.
+  * @return The sample period, in milliseconds.
+  */
+unsigned long MicroBitCompass::systemTickPeriod()
+{
+    return samplePeriod;
+}
+
 /**
   * Destructor for MicroBitMessageBus, so that we deregister ourselves as an idleComponent
   */
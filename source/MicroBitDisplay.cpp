@@ -10,6 +10,15 @@
 
 const float timings[MICROBIT_DISPLAY_GREYSCALE_BIT_DEPTH] = {0.000010, 0.000047, 0.000094, 0.000187, 0.000375, 0.000750, 0.001500, 0.003000};
 
+/**
+  * Event handler for MICROBIT_DISPLAY_EVT_LIGHT_SENSE, that forwards it to uBit.display.
+  * Called through the static listener table of the device (see microbit_static_listeners).
+  */
+void onDisplayLightSenseEvent(MicroBitEvent evt)
+{
+    uBit.display.onLightSenseEvent(evt);
+}
+
 /**
   * Constructor.
   * Create a representation of a display of a given size.
@@ -90,6 +99,32 @@ void MicroBitDisplay::systemTick()
     this->animationUpdate();
 }
 
+/**
+  * Determines how long the display can go without a system tick while the processor is idle.
+  * The display needs every tick whilst it is showing anything, or running an animation.
+  * @return 0 if the display needs every system tick, or MICROBIT_TICK_PERIOD_UNLIMITED otherwise.
+  */
+unsigned long MicroBitDisplay::systemTickPeriod()
+{
+    if(!(uBit.flags & MICROBIT_FLAG_DISPLAY_RUNNING))
+        return MICROBIT_TICK_PERIOD_UNLIMITED;
+
+    if(animationMode != ANIMATION_MODE_NONE || mode == DISPLAY_MODE_BLACK_AND_WHITE_LIGHT_SENSE)
+        return 0;
+
+    // A blank display is left blank by the last row strobed, so doesn't need refreshing.
+    if(brightness > 0)
+    {
+        uint8_t *bitmap = image.getBitmap();
+
+        for(int i = 0; i < image.getWidth() * image.getHeight(); i++)
+            if(bitmap[i])
+                return 0;
+    }
+
+    return MICROBIT_TICK_PERIOD_UNLIMITED;
+}
+
 void MicroBitDisplay::renderFinish()
 {
     //kept inline to reduce overhead
@@ -938,9 +973,12 @@ void MicroBitDisplay::setDisplayMode(DisplayMode mode)
         if(uBit.getTickPeriod() != MICROBIT_DEFAULT_TICK_PERIOD)
             uBit.setTickPeriod(MICROBIT_DEFAULT_TICK_PERIOD);
 
-        delete this->lightSensor;
+        // Detach the light sensor before deleting it, as onLightSenseEvent() can run in interrupt context.
+        MicroBitLightSensor *sensor = this->lightSensor;
 
         this->lightSensor = NULL;
+
+        delete sensor;
     }
 
     this->mode = mode;
@@ -1169,6 +1207,17 @@ int MicroBitDisplay::readLightLevel()
     return this->lightSensor->read();
 }
 
+/**
+  * Event handler for MICROBIT_DISPLAY_EVT_LIGHT_SENSE, which the display raises when it is ready for the light
+  * sensor to take a reading. Starts the light sensor sensing, if it is in use.
+  * Called through onDisplayLightSenseEvent().
+  */
+void MicroBitDisplay::onLightSenseEvent(MicroBitEvent evt)
+{
+    if(this->lightSensor != NULL)
+        this->lightSensor->startSensing(evt);
+}
+
 /**
   * Destructor for MicroBitDisplay, so that we deregister ourselves as a systemComponent
   */
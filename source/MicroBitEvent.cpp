@@ -6,6 +6,10 @@
 
 #include "MicroBit.h"
 
+static uint32_t eventQueueItemStorage[MICROBIT_POOL_STORAGE(sizeof(MicroBitEventQueueItem), MESSAGE_BUS_EVENT_QUEUE_POOL_SIZE)];
+
+MicroBitPool eventQueueItemPool = { eventQueueItemStorage, MICROBIT_POOL_OBJECT_SIZE(sizeof(MicroBitEventQueueItem)), MESSAGE_BUS_EVENT_QUEUE_POOL_SIZE };
+
 /**
   * Constructor. 
   * @param src ID of the MicroBit Component that generated the event e.g. MICROBIT_ID_BUTTON_A.
@@ -22,6 +26,10 @@ MicroBitEvent::MicroBitEvent(uint16_t source, uint16_t value, MicroBitEventLaunc
     this->source = source;
     this->value = value;
     this->timestamp = ticks;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    this->latencyFrom = us_ticker_read();
+#endif
     
     if(mode != CREATE_ONLY)
         this->fire(mode);
@@ -35,6 +43,10 @@ MicroBitEvent::MicroBitEvent()
     this->source = 0;
     this->value = 0;
     this->timestamp = ticks;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    this->latencyFrom = us_ticker_read();
+#endif
 }
 
 /**
@@ -47,6 +59,9 @@ void MicroBitEvent::fire(MicroBitEventLaunchMode mode)
 
     else if (mode == CREATE_AND_FIRE)
         uBit.MessageBus.process(*this);
+
+    else if (mode == CREATE_AND_COALESCE)
+        uBit.MessageBus.coalesce(*this);
 }
 
 /**
@@ -69,3 +84,22 @@ MicroBitEventQueueItem::MicroBitEventQueueItem(MicroBitEvent evt)
 	this->next = NULL;
 }
 
+
+/**
+  * Allocates memory for a MicroBitEventQueueItem from eventQueueItemPool, or the heap should the pool be empty.
+  */
+void *MicroBitEventQueueItem::operator new(size_t size)
+{
+    void *p = eventQueueItemPool.allocate();
+
+    return p ? p : microbit_malloc(size);
+}
+
+/**
+  * Releases the memory of a MicroBitEventQueueItem back to wherever it was allocated from.
+  */
+void MicroBitEventQueueItem::operator delete(void *ptr)
+{
+    if (!eventQueueItemPool.release(ptr))
+        microbit_free(ptr);
+}
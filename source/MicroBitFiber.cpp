@@ -20,10 +20,28 @@ Fiber *idleFiber = NULL;                    // IDLE task - performs a power effi
 /*
  * Scheduler state.
  */
-Fiber *runQueue = NULL;                     // The list of runnable fibers.
+Fiber *runQueue[FIBER_PRIORITY_LEVELS];     // The lists of runnable fibers, one per priority level.
 Fiber *sleepQueue = NULL;                   // The list of blocked fibers waiting on a fiber_sleep() operation.
-Fiber *waitQueue = NULL;                    // The list of blocked fibers waiting on an event.
+Fiber *waitQueue[FIBER_WAIT_QUEUE_BUCKETS]; // The lists of blocked fibers waiting on an event, hashed on that event.
 Fiber *fiberPool = NULL;                    // Pool of unused fibers, just waiting for a job to do.
+Fiber *forkReserve = NULL;                  // Unused fibers reserved for fork on block, with stack buffers sized for the deepest fork seen.
+
+/*
+ * Scheduler statistics for each priority level, and the set of levels (as a bitmask) scheduled since the last tick.
+ */
+FiberPriorityStatistics priorityStatistics[FIBER_PRIORITY_LEVELS];
+uint32_t prioritiesScheduled = 0;
+
+/*
+ * Fiber pool statistics. The pooled and reservedBytes fields are calculated on demand by fiber_pool_statistics().
+ */
+FiberPoolStatistics poolStatistics;
+
+/*
+ * Incremented each time a fiber starts waiting for an event.
+ * Used to keep NOTIFY_ONE first come, first served across the wait queue buckets.
+ */
+uint32_t waitOrder = 0;
 
 /*
  * Time since power on. Measured in milliseconds.
@@ -36,11 +54,55 @@ unsigned long ticks = 0;
  */
 uint8_t fiber_flags = 0;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Determines if the given queue is one of the run queues.
+  */
+static inline int is_run_queue(Fiber **queue)
+{
+    return queue >= &runQueue[0] && queue < &runQueue[FIBER_PRIORITY_LEVELS];
+}
+
+/**
+  * Updates the scheduler statistics of two fibers, as the processor is handed from one to the other.
+  *
+  * @param from The fiber being scheduled out.
+  * @param to The fiber being scheduled in.
+  */
+static void fiber_statistics_switch(Fiber *from, Fiber *to)
+{
+    uint32_t now = us_ticker_read();
+
+    from->statistics.runTime += now - from->statistics.scheduledAt;
+
+    // A fiber that is scheduled out without blocking is immediately waiting to run again.
+    if (is_run_queue(from->queue))
+        from->statistics.runnableAt = now;
+
+    // The idle fiber is never runnable as such, it just runs when nothing else can.
+    if (to != idleFiber && now - to->statistics.runnableAt > to->statistics.maxLatency)
+        to->statistics.maxLatency = now - to->statistics.runnableAt;
+
+    to->statistics.switches++;
+    to->statistics.scheduledAt = now;
+}
+#endif
+
+/**
+  * Records a context switch in the event trace (see MicroBitTrace.h).
+  *
+  * @param from The fiber being scheduled out.
+  * @param to The fiber being scheduled in.
+  */
+static inline void fiber_trace_switch(Fiber *from, Fiber *to)
+{
+    microbit_trace(MICROBIT_TRACE_FIBER_SWITCH, MICROBIT_TRACE_FIBER(from), MICROBIT_TRACE_FIBER(to), to == idleFiber ? MICROBIT_TRACE_IDLE : to->priority);
+}
+
 /**
   * Utility function to add the currenty running fiber to the given queue.
-  * Perform a simple add at the head, to avoid complexity,
-  * Queues are normally very short, so maintaining a doubly linked, sorted list typically outweighs the cost of
-  * brute force searching.
+  * Queues are doubly linked, and the prev field of the fiber at the head of a queue refers to the tail.
+  * This lets us add at the tail in constant time, without the RAM cost of a separate tail pointer.
   *
   * @param f The fiber to add to the queue
   * @param queue The run queue to add the fiber to.
@@ -51,29 +113,88 @@ void queue_fiber(Fiber *f, Fiber **queue)
 
     // Record which queue this fiber is on.
     f->queue = queue;
+    f->next = NULL;
 
-    // Add the fiber to the tail of the queue. Although this involves scanning the
-    // list, it results in fairer scheduling.
+    // Add the fiber to the tail of the queue, which results in fairer scheduling.
     if (*queue == NULL)
     {
-        f->next = NULL;
-        f->prev = NULL;
+        f->prev = f;
         *queue = f;
     }
     else
     {
-        // Scan to the end of the queue.
-        // We don't maintain a tail pointer to save RAM (queues are nrmally very short).
-        Fiber *last = *queue;
-
-        while (last->next != NULL)
-            last = last->next;
+        Fiber *last = (*queue)->prev;
 
         last->next = f;
         f->prev = last;
-        f->next = NULL;
+        (*queue)->prev = f;
     }
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    if (is_run_queue(queue))
+        f->statistics.runnableAt = us_ticker_read();
+#endif
+
+    __enable_irq();
+}
+
+/**
+  * Utility function to add the given fiber to the given queue, keeping the queue sorted by the context field
+  * (lowest first). Fibers with equal context are kept in the order they were added.
+  *
+  * The queue is scanned from whichever end is nearest in value, so adding a fiber that belongs at either the
+  * head or the tail (the common cases) takes constant time.
+  *
+  * @param f The fiber to add to the queue
+  * @param queue The queue to add the fiber to.
+  */
+void queue_fiber_sorted(Fiber *f, Fiber **queue)
+{
+    __disable_irq();
+
+    Fiber *head = *queue;
+
+    // If the fiber belongs at the tail, this is just a normal queue operation.
+    if (head == NULL || head->prev->context <= f->context)
+    {
+        __enable_irq();
+        queue_fiber(f, queue);
+        return;
+    }
+
+    // Otherwise, find the fiber that we need to insert in front of.
+    Fiber *next;
+
+    if (f->context < head->context)
+    {
+        next = head;
+    }
+    else if (f->context - head->context < head->prev->context - f->context)
+    {
+        next = head;
+
+        while (next->context <= f->context)
+            next = next->next;
+    }
+    else
+    {
+        next = head->prev;
+
+        while (next != head && next->prev->context > f->context)
+            next = next->prev;
+    }
+
+    f->queue = queue;
+    f->next = next;
+    f->prev = next->prev;
+
+    if (next == head)
+        *queue = f;
+    else
+        next->prev->next = f;
+
+    next->prev = f;
+
     __enable_irq();
 }
 
@@ -90,13 +211,18 @@ void dequeue_fiber(Fiber *f)
     // Remove this fiber fromm whichever queue it is on.
     __disable_irq();
 
-    if (f->prev != NULL)
-        f->prev->next = f->next;
-    else
+    Fiber *head = *(f->queue);
+
+    if (f == head)
         *(f->queue) = f->next;
+    else
+        f->prev->next = f->next;
 
-    if(f->next)
+    // Maintain the reference from the head of the queue to the tail.
+    if (f->next)
         f->next->prev = f->prev;
+    else if (f != head)
+        head->prev = f->prev;
 
     f->next = NULL;
     f->prev = NULL;
@@ -106,6 +232,67 @@ void dequeue_fiber(Fiber *f)
 
 }
 
+/**
+  * Determines the run queue for the given fiber, according to its priority.
+  */
+static inline Fiber **run_queue(Fiber *f)
+{
+    return &runQueue[f->priority];
+}
+
+/**
+  * Determines the run queue of the highest priority level that has runnable fibers.
+  * @return The run queue, or NULL if no fibers are runnable.
+  */
+static inline Fiber **highest_run_queue()
+{
+    for (int i = FIBER_PRIORITY_LEVELS - 1; i >= 0; i--)
+        if (runQueue[i] != NULL)
+            return &runQueue[i];
+
+    return NULL;
+}
+
+/**
+  * Records a change in the memory held by fiber stack buffers.
+  *
+  * @param bytes The number of bytes allocated, or released if negative.
+  */
+static inline void fiber_stack_allocated(int bytes)
+{
+    __disable_irq();
+
+    poolStatistics.stackBytes += bytes;
+
+    if (poolStatistics.stackBytes > poolStatistics.maxStackBytes)
+        poolStatistics.maxStackBytes = poolStatistics.stackBytes;
+
+    __enable_irq();
+}
+
+/**
+  * Determines the size of stack buffer to allocate for a stack of the given depth.
+  * To ease heap churn, we choose the next largest multple of 32 bytes.
+  */
+static inline uint32_t fiber_stack_buffer_size(uint32_t stackDepth)
+{
+    return (stackDepth + 32) & 0xffffffe0;
+}
+
+/**
+  * Ensures the given fiber is in suitable state for reuse.
+  */
+static inline void reset_fiber(Fiber *f)
+{
+    f->flags = 0;
+    f->priority = FIBER_PRIORITY_NORMAL;
+    f->tcb.stack_base = CORTEX_M0_STACK_BASE;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    memset(&f->statistics, 0, sizeof(FiberStatistics));
+#endif
+}
+
 /**
   * Allocates a fiber from the fiber pool if availiable. Otherwise, allocates a new one from the heap.
   */
@@ -115,6 +302,9 @@ Fiber *getFiberContext()
 
     __disable_irq();
 
+    if (++poolStatistics.active > poolStatistics.maxActive)
+        poolStatistics.maxActive = poolStatistics.active;
+
     if (fiberPool != NULL)
     {
         f = fiberPool;
@@ -123,25 +313,112 @@ Fiber *getFiberContext()
     }
     else
     {
+        poolStatistics.fibers++;
+
         __enable_irq();
 
         f = new Fiber();
 
         if (f == NULL)
+        {
+            __disable_irq();
+            poolStatistics.fibers--;
+            poolStatistics.active--;
+            __enable_irq();
+
             return NULL;
+        }
 
         f->stack_bottom = 0;
         f->stack_top = 0;
     }
 
-    // Ensure this fiber is in suitable state for reuse.
-    f->flags = 0;
-    f->tcb.stack_base = CORTEX_M0_STACK_BASE;
+    reset_fiber(f);
+
+    return f;
+}
+
+/**
+  * Allocates a fiber to fork on block into. This will come from the fork on block reserve if availiable, in which case
+  * the fork doesn't touch the heap. Otherwise, the fiber is allocated by getFiberContext().
+  */
+static Fiber *getForkContext()
+{
+    Fiber *f;
+
+    __disable_irq();
+
+    if (forkReserve == NULL)
+    {
+        poolStatistics.forkMisses++;
+        __enable_irq();
+
+        return getFiberContext();
+    }
+
+    poolStatistics.forkHits++;
+    poolStatistics.reserved--;
+
+    if (++poolStatistics.active > poolStatistics.maxActive)
+        poolStatistics.maxActive = poolStatistics.active;
+
+    f = forkReserve;
+    dequeue_fiber(f);
+    // dequeue_fiber() exits with irqs enabled, so no need to do this again!
+
+    reset_fiber(f);
 
     return f;
 }
 
 
+/**
+  * Returns a fiber that is no longer in use to the fork on block reserve if it is not full, for reuse by getForkContext().
+  * Otherwise, returns it to the fiber pool, for reuse by getFiberContext().
+  */
+static void recycle_fiber(Fiber *f)
+{
+    Fiber **queue = &fiberPool;
+
+    if (poolStatistics.reserved < FIBER_FORK_RESERVE && !(f->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK))
+    {
+        queue = &forkReserve;
+
+        // Make sure the stack buffer is large enough for the deepest fork seen so far, so that the next fork
+        // into this fiber won't need to grow it. The fiber has completed, so its stack buffer is no longer needed.
+        uint32_t bufferSize = f->stack_top - f->stack_bottom;
+
+        if (poolStatistics.maxForkStackDepth > bufferSize)
+        {
+            if (f->stack_bottom != 0)
+            {
+                free((void *)f->stack_bottom);
+                fiber_stack_allocated(-bufferSize);
+            }
+
+            bufferSize = fiber_stack_buffer_size(poolStatistics.maxForkStackDepth);
+            f->stack_bottom = (uint32_t)(uintptr_t) malloc(bufferSize);
+
+            if (f->stack_bottom != 0)
+                fiber_stack_allocated(bufferSize);
+            else
+                bufferSize = 0;
+
+            f->stack_top = f->stack_bottom + bufferSize;
+        }
+    }
+
+    __disable_irq();
+
+    poolStatistics.active--;
+
+    if (queue == &forkReserve)
+        poolStatistics.reserved++;
+
+    queue_fiber(f, queue);
+    // queue_fiber() exits with irqs enabled, so no need to do this again!
+}
+
 /**
   * Initialises the Fiber scheduler.
   * Creates a Fiber context around the calling thread, and adds it to the run queue as the current thread.
@@ -154,7 +431,7 @@ void scheduler_init()
     currentFiber = getFiberContext();
 
     // Add ourselves to the run queue.
-    queue_fiber(currentFiber, &runQueue);
+    queue_fiber(currentFiber, run_queue(currentFiber));
 
     // Create the IDLE fiber.
     // Configure the fiber to directly enter the idle task.
@@ -162,43 +439,102 @@ void scheduler_init()
     idleFiber->tcb.SP = CORTEX_M0_STACK_BASE - 0x04;
     idleFiber->tcb.LR = (uint32_t) &idle_task;
 
-    // Register to receive events in the NOTIFY channel - this is used to implement wait-notify semantics
-    uBit.MessageBus.listen(MICROBIT_ID_NOTIFY, MICROBIT_EVT_ANY, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
-    uBit.MessageBus.listen(MICROBIT_ID_NOTIFY_ONE, MICROBIT_EVT_ANY, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
+    // Fill the fork on block reserve. Stack buffers are allocated as forks are seen.
+    for (int i = 0; i < FIBER_FORK_RESERVE; i++)
+    {
+        Fiber *f = getFiberContext();
+
+        if (f != NULL)
+            recycle_fiber(f);
+    }
+
+    // n.b. Events in the NOTIFY channels, used to implement wait-notify semantics, reach scheduler_event() through
+    // the static listener table of the device (see microbit_static_listeners), so need no listener here.
 
     // Flag that we now have a scheduler running
     uBit.flags |= MICROBIT_FLAG_SCHEDULER_RUNNING;
 }
 
 /**
-  * Timer callback. Called from interrupt context, once every FIBER_TICK_PERIOD_MS milliseconds.
+  * Timer callback. Called from interrupt context, once every system tick period (normally FIBER_TICK_PERIOD_MS milliseconds).
   * Simply checks to determine if any fibers blocked on the sleep queue need to be woken up
   * and made runnable.
   */
 void scheduler_tick()
 {
-    Fiber *f = sleepQueue;
-    Fiber *t;
+    Fiber *f;
 
     // increment our real-time counter.
     ticks += uBit.getTickPeriod();
 
-    // Check the sleep queue, and wake up any fibers as necessary.
-    while (f != NULL)
+    // Account for any priority levels with runnable fibers that haven't been scheduled since the last tick.
+    // The currently running fiber may well have been running throughout, so doesn't count as starved.
+    for (int i = 0; i < FIBER_PRIORITY_LEVELS; i++)
     {
-        t = f->next;
+        FiberPriorityStatistics *stats = &priorityStatistics[i];
 
-        if (ticks >= f->context)
+        if (runQueue[i] != NULL && !(prioritiesScheduled & (1 << i)) && currentFiber->queue != &runQueue[i])
         {
-            // Wakey wakey!
-            dequeue_fiber(f);
-            queue_fiber(f,&runQueue);
+            stats->starvedTicks++;
+            stats->currentStarvedTicks++;
+
+            if (stats->currentStarvedTicks > stats->maxStarvedTicks)
+                stats->maxStarvedTicks = stats->currentStarvedTicks;
         }
+        else
+        {
+            stats->currentStarvedTicks = 0;
+        }
+    }
 
-        f = t;
+    prioritiesScheduled = 0;
+
+    // Wake up any fibers as necessary. The sleep queue is sorted by wake up time,
+    // so we can stop at the first fiber that isn't due.
+    while ((f = sleepQueue) != NULL && ticks >= f->context)
+    {
+        // Wakey wakey!
+        dequeue_fiber(f);
+        queue_fiber(f, run_queue(f));
     }
 }
 
+/**
+  * Determines how long it will be until a sleeping fiber is next due to be woken up.
+  * @return The time in milliseconds (0 if a fiber is already due), or MICROBIT_TICK_PERIOD_UNLIMITED if no fibers are sleeping.
+  */
+unsigned long scheduler_next_wakeup()
+{
+    unsigned long period = MICROBIT_TICK_PERIOD_UNLIMITED;
+
+    __disable_irq();
+
+    // The sleep queue is sorted by wake up time, so we need only look at the head.
+    if (sleepQueue != NULL)
+        period = sleepQueue->context > ticks ? sleepQueue->context - ticks : 0;
+
+    __enable_irq();
+
+    return period;
+}
+
+/**
+  * Determines the wait queue bucket for fibers waiting on the given event.
+  *
+  * Fibers waiting on MICROBIT_ID_ANY are all held in a single bucket, so at most three buckets
+  * (specific event, any value of the event's source and any source) need to be checked per event.
+  *
+  * @param id The ID field of the event.
+  * @param value The VALUE field of the event.
+  */
+static inline Fiber **wait_queue(uint16_t id, uint16_t value)
+{
+    if (id == MICROBIT_ID_ANY)
+        value = MICROBIT_EVT_ANY;
+
+    return &waitQueue[(id + value) & (FIBER_WAIT_QUEUE_BUCKETS - 1)];
+}
+
 /**
   * Event callback. Called from the message bus whenever an event is raised.
   * Checks to determine if any fibers blocked on the wait queue need to be woken up
@@ -206,40 +542,67 @@ void scheduler_tick()
   */
 void scheduler_event(MicroBitEvent evt)
 {
-    Fiber *f = waitQueue;
-    Fiber *t;
-    int notifyOneComplete = 0;
-
-    // Check the wait queue, and wake up any fibers as necessary.
-    while (f != NULL)
+    Fiber **buckets[5];
+    int bucketCount = 0;
+    Fiber *notifyOne = NULL;
+
+    // Determine which buckets may hold fibers waiting on this event.
+    Fiber **candidates[5] = {
+        wait_queue(evt.source, evt.value),
+        wait_queue(evt.source, MICROBIT_EVT_ANY),
+        wait_queue(MICROBIT_ID_ANY, MICROBIT_EVT_ANY),
+        wait_queue(MICROBIT_ID_NOTIFY, evt.value),
+        wait_queue(MICROBIT_ID_NOTIFY, MICROBIT_EVT_ANY)
+    };
+
+    for (int i = 0; i < (evt.source == MICROBIT_ID_NOTIFY_ONE ? 5 : 3); i++)
     {
-        t = f->next;
+        int j = 0;
+
+        while (j < bucketCount && buckets[j] != candidates[i])
+            j++;
 
-        // extract the event data this fiber is blocked on.
-        uint16_t id = f->context & 0xFFFF;
-        uint16_t value = (f->context & 0xFFFF0000) >> 16;
+        if (j == bucketCount)
+            buckets[bucketCount++] = candidates[i];
+    }
 
-        // Special case for the NOTIFY_ONE channel...
-        if ((evt.source == MICROBIT_ID_NOTIFY_ONE && id == MICROBIT_ID_NOTIFY) && (value == MICROBIT_EVT_ANY || value == evt.value))
+    // Check each bucket, and wake up any fibers as necessary.
+    for (int i = 0; i < bucketCount; i++)
+    {
+        Fiber *f = *buckets[i];
+        Fiber *t;
+
+        while (f != NULL)
         {
-            if (!notifyOneComplete)
+            t = f->next;
+
+            // extract the event data this fiber is blocked on.
+            uint16_t id = f->context & 0xFFFF;
+            uint16_t value = (f->context & 0xFFFF0000) >> 16;
+
+            // Special case for the NOTIFY_ONE channel... only the longest waiting fiber is woken.
+            if ((evt.source == MICROBIT_ID_NOTIFY_ONE && id == MICROBIT_ID_NOTIFY) && (value == MICROBIT_EVT_ANY || value == evt.value))
+            {
+                if (notifyOne == NULL || (int32_t)(f->order - notifyOne->order) < 0)
+                    notifyOne = f;
+            }
+
+            // Normal case.
+            else if ((id == MICROBIT_ID_ANY || id == evt.source) && (value == MICROBIT_EVT_ANY || value == evt.value))
             {
                 // Wakey wakey!
                 dequeue_fiber(f);
-                queue_fiber(f,&runQueue);
-                notifyOneComplete = 1;
+                queue_fiber(f, run_queue(f));
             }
-        }
 
-        // Normal case.
-        else if ((id == MICROBIT_ID_ANY || id == evt.source) && (value == MICROBIT_EVT_ANY || value == evt.value))
-        {
-            // Wakey wakey!
-            dequeue_fiber(f);
-            queue_fiber(f,&runQueue);
+            f = t;
         }
+    }
 
-        f = t;
+    if (notifyOne != NULL)
+    {
+        dequeue_fiber(notifyOne);
+        queue_fiber(notifyOne, run_queue(notifyOne));
     }
 
     // Unregister this event, as we've woken up all the fibers with this match.
@@ -266,14 +629,17 @@ void fiber_sleep(unsigned long t)
     // it's time to spawn a new fiber...
     if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
     {
-        // Allocate a new fiber. This will come from the fiber pool if availiable,
+        // Allocate a new fiber. This will come from the fork on block reserve or the fiber pool if availiable,
         // else a new one will be allocated on the heap.
-        forkedFiber = getFiberContext();
+        forkedFiber = getForkContext();
 
         // If we're out of memory, there's nothing we can do.
         // keep running in the context of the current thread as a best effort.
         if (forkedFiber != NULL)
-                f = forkedFiber;
+        {
+            forkedFiber->priority = currentFiber->priority;
+            f = forkedFiber;
+        }
     }
 
     // Calculate and store the time we want to wake up.
@@ -283,7 +649,7 @@ void fiber_sleep(unsigned long t)
     dequeue_fiber(f);
 
     // Add fiber to the sleep queue. We maintain strict ordering here to reduce lookup times.
-    queue_fiber(f, &sleepQueue);
+    queue_fiber_sorted(f, &sleepQueue);
 
     // Finally, enter the scheduler.
     schedule();
@@ -308,27 +674,31 @@ void fiber_wait_for_event(uint16_t id, uint16_t value)
     // it's time to spawn a new fiber...
     if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
     {
-        // Allocate a TCB from the new fiber. This will come from the tread pool if availiable,
+        // Allocate a TCB from the new fiber. This will come from the fork on block reserve or the tread pool if availiable,
         // else a new one will be allocated on the heap.
-        forkedFiber = getFiberContext();
+        forkedFiber = getForkContext();
 
         // If we're out of memory, there's nothing we can do.
         // keep running in the context of the current thread as a best effort.
         if (forkedFiber != NULL)
-                f = forkedFiber;
+        {
+            forkedFiber->priority = currentFiber->priority;
+            f = forkedFiber;
+        }
     }
 
     // Encode the event data in the context field. It's handy having a 32 bit core. :-)
     f->context = value << 16 | id;
+    f->order = waitOrder++;
 
     // Remove ourselve from the run queue
     dequeue_fiber(f);
 
-    // Add ourselves to the sleep queue. We maintain strict ordering here to reduce lookup times.
-    queue_fiber(f, &waitQueue);
+    // Add ourselves to the wait queue, in the bucket for the event we're waiting on.
+    queue_fiber(f, wait_queue(id, value));
 
     // Register to receive this event, so we can wake up the fiber when it happens.
-    // Special case for teh notify channel, as we always stay registered for that.
+    // Special case for the notify channels, as the static listener table always delivers those.
     if (id != MICROBIT_ID_NOTIFY && id != MICROBIT_ID_NOTIFY_ONE)
         uBit.MessageBus.listen(id, value, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
 
@@ -336,6 +706,35 @@ void fiber_wait_for_event(uint16_t id, uint16_t value)
     schedule();
 }
 
+/**
+  * Makes the longest waiting fiber on the given queue runnable again.
+  * Components that need a wake-up of their own, which user code can neither wait on nor raise (unlike the notify
+  * channels), keep a private queue of their waiting fibers, and move the current fiber onto it before calling schedule().
+  * Safe to call from interrupt context.
+  *
+  * @param queue The queue of waiting fibers.
+  * @return The fiber woken, or NULL if no fiber was waiting.
+  */
+Fiber *fiber_wake_one(Fiber **queue)
+{
+    __disable_irq();
+
+    Fiber *f = *queue;
+
+    if (f == NULL)
+    {
+        __enable_irq();
+        return NULL;
+    }
+
+    dequeue_fiber(f);
+    // dequeue_fiber() exits with irqs enabled, so no need to do this again!
+
+    queue_fiber(f, run_queue(f));
+
+    return f;
+}
+
 /**
   * Executes the given function asynchronously.
   *
@@ -354,16 +753,22 @@ int invoke(void (*entry_fn)(void))
     if (entry_fn == NULL)
         return MICROBIT_INVALID_PARAMETER;
 
-    if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
+    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_DEDICATED_STACK))
     {
         // If we attempt a fork on block whilst already in  fork n block context,
         // simply launch a fiber to deal with the request and we're done.
+        // The same applies to fibers with a dedicated stack, as a forked fiber can only be paged in
+        // and out of the system stack.
         create_fiber(entry_fn);
         return MICROBIT_OK;
     }
 
     // Snapshot current context, but also update the Link Register to
     // refer to our calling function.
+    // The function runs in our context, so may change our priority (see fiber_set_priority()).
+    // Remember it, so it can be restored afterwards.
+    int priority = currentFiber->priority;
+
     save_register_context(&currentFiber->tcb);
 
     // If we're here, there are two possibilities:
@@ -375,6 +780,10 @@ int invoke(void (*entry_fn)(void))
     {
         currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
         currentFiber->flags &= ~MICROBIT_FIBER_FLAG_PARENT;
+
+        if (currentFiber->priority != priority)
+            fiber_set_priority(priority);
+
         return MICROBIT_OK;
     }
 
@@ -385,6 +794,9 @@ int invoke(void (*entry_fn)(void))
     entry_fn();
     currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
 
+    if (currentFiber->priority != priority)
+        fiber_set_priority(priority);
+
     // If this is is an exiting fiber that for spawned to handle a blocking call, recycle it.
     // The fiber will then re-enter the scheduler, so no need for further cleanup.
     if (currentFiber->flags & MICROBIT_FIBER_FLAG_CHILD)
@@ -412,16 +824,22 @@ int invoke(void (*entry_fn)(void *), void *param)
     if (entry_fn == NULL)
         return MICROBIT_INVALID_PARAMETER;
 
-    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_PARENT | MICROBIT_FIBER_FLAG_CHILD))
+    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_PARENT | MICROBIT_FIBER_FLAG_CHILD | MICROBIT_FIBER_FLAG_DEDICATED_STACK))
     {
         // If we attempt a fork on block whilst already in a fork on block context,
         // simply launch a fiber to deal with the request and we're done.
+        // The same applies to fibers with a dedicated stack, as a forked fiber can only be paged in
+        // and out of the system stack.
         create_fiber(entry_fn, param);
         return MICROBIT_OK;
     }
 
     // Snapshot current context, but also update the Link Register to
     // refer to our calling function.
+    // The function runs in our context, so may change our priority (see fiber_set_priority()).
+    // Remember it, so it can be restored afterwards.
+    int priority = currentFiber->priority;
+
     save_register_context(&currentFiber->tcb);
 
     // If we're here, there are two possibilities:
@@ -433,6 +851,10 @@ int invoke(void (*entry_fn)(void *), void *param)
     {
         currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
         currentFiber->flags &= ~MICROBIT_FIBER_FLAG_PARENT;
+
+        if (currentFiber->priority != priority)
+            fiber_set_priority(priority);
+
         return MICROBIT_OK;
     }
 
@@ -443,6 +865,9 @@ int invoke(void (*entry_fn)(void *), void *param)
     entry_fn(param);
     currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
 
+    if (currentFiber->priority != priority)
+        fiber_set_priority(priority);
+
     // If this is is an exiting fiber that for spawned to handle a blocking call, recycle it.
     // The fiber will then re-enter the scheduler, so no need for further cleanup.
     if (currentFiber->flags & MICROBIT_FIBER_FLAG_CHILD)
@@ -475,7 +900,7 @@ void launch_new_fiber_param(void (*ep)(void *), void (*cp)(void *), void *pm)
     release_fiber(pm);
 }
 
-Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
+Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised, uint32_t flags)
 {
     // Validate our parameters.
     if (ep == 0 || cp == 0)
@@ -493,12 +918,50 @@ Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
     newFiber->tcb.R1 = (uint32_t) cp;
     newFiber->tcb.R2 = (uint32_t) pm;
 
+    if (flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK)
+    {
+        // Reuse the stack buffer of a recycled fiber if it is large enough, otherwise allocate a new one.
+        if (newFiber->stack_top - newFiber->stack_bottom < FIBER_DEDICATED_STACK_SIZE)
+        {
+            if (newFiber->stack_bottom != 0)
+            {
+                free((void *)newFiber->stack_bottom);
+                fiber_stack_allocated(newFiber->stack_bottom - newFiber->stack_top);
+            }
+
+            newFiber->stack_bottom = (uint32_t)(uintptr_t) malloc(FIBER_DEDICATED_STACK_SIZE);
+            newFiber->stack_top = newFiber->stack_bottom + FIBER_DEDICATED_STACK_SIZE;
+
+            if (newFiber->stack_bottom == 0)
+            {
+                newFiber->stack_top = 0;
+                recycle_fiber(newFiber);
+                return NULL;
+            }
+
+            fiber_stack_allocated(FIBER_DEDICATED_STACK_SIZE);
+        }
+
+        *((uint32_t *)newFiber->stack_bottom) = MICROBIT_FIBER_STACK_CANARY;
+
+        // Align the stack in the same way as the system stack.
+        newFiber->tcb.stack_base = (newFiber->stack_top & ~0x0F) - (MICROBIT_SRAM_END - CORTEX_M0_STACK_BASE);
+        newFiber->flags |= MICROBIT_FIBER_FLAG_DEDICATED_STACK;
+    }
+
     // Set the stack and assign the link register to refer to the appropriate entry point wrapper.
-    newFiber->tcb.SP = CORTEX_M0_STACK_BASE - 0x04;
+    newFiber->tcb.SP = newFiber->tcb.stack_base - 0x04;
     newFiber->tcb.LR = parameterised ? (uint32_t) &launch_new_fiber_param : (uint32_t) &launch_new_fiber;
 
+    if (flags & MICROBIT_FIBER_FLAG_PRIORITY(0))
+        newFiber->priority = min((flags >> 9) & 0x0F, FIBER_PRIORITY_LEVELS - 1);
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    newFiber->statistics.entry = ep;
+#endif
+
     // Add new fiber to the run queue.
-    queue_fiber(newFiber, &runQueue);
+    queue_fiber(newFiber, run_queue(newFiber));
 
     return newFiber;
 }
@@ -508,11 +971,13 @@ Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
   *
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param completion_fn The function called when the thread completes execution of entry_fn.
-  * @return The new Fiber.
+  * @param flags MICROBIT_FIBER_FLAG_DEDICATED_STACK to give the fiber a dedicated stack of FIBER_DEDICATED_STACK_SIZE
+  * bytes, rather than paging its stack in and out of the system stack (optional).
+  * @return The new Fiber, or NULL if there is insufficient memory available.
   */
-Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void))
+Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void), uint32_t flags)
 {
-    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, 0, 0);
+    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, 0, 0, flags);
 }
 
 
@@ -522,11 +987,13 @@ Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void))
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param param an untyped parameter passed into the entry_fn anf completion_fn.
   * @param completion_fn The function called when the thread completes execution of entry_fn.
-  * @return The new Fiber.
+  * @param flags MICROBIT_FIBER_FLAG_DEDICATED_STACK to give the fiber a dedicated stack of FIBER_DEDICATED_STACK_SIZE
+  * bytes, rather than paging its stack in and out of the system stack (optional).
+  * @return The new Fiber, or NULL if there is insufficient memory available.
   */
-Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *))
+Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *), uint32_t flags)
 {
-    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, (uint32_t) param, 1);
+    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, (uint32_t) param, 1, flags);
 }
 
 /**
@@ -548,7 +1015,7 @@ void release_fiber(void)
     dequeue_fiber(currentFiber);
 
     // Add ourselves to the list of free fibers
-    queue_fiber(currentFiber, &fiberPool);
+    recycle_fiber(currentFiber);
 
     // Find something else to do!
     schedule();
@@ -561,8 +1028,9 @@ void release_fiber(void)
   * Otherwise, the the current allocation of the fiber is freed, and a larger block is allocated.
   *
   * @param f The fiber context to verify.
+  * @return The stack depth of the given fiber.
   */
-void verify_stack_size(Fiber *f)
+uint32_t verify_stack_size(Fiber *f)
 {
     // Ensure the stack buffer is large enough to hold the stack Reallocate if necessary.
     uint32_t stackDepth;
@@ -571,25 +1039,48 @@ void verify_stack_size(Fiber *f)
     // Calculate the stack depth.
     stackDepth = f->tcb.stack_base - ((uint32_t) __get_MSP());
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    if (stackDepth > f->statistics.maxStackDepth)
+        f->statistics.maxStackDepth = stackDepth;
+#endif
+
     // Calculate the size of our allocated stack buffer
     bufferSize = f->stack_top - f->stack_bottom;
 
     // If we're too small, increase our buffer size.
     if (bufferSize < stackDepth)
     {
-        // To ease heap churn, we choose the next largest multple of 32 bytes.
-        bufferSize = (stackDepth + 32) & 0xffffffe0;
-
         // Release the old memory
         if (f->stack_bottom != 0)
+        {
             free((void *)f->stack_bottom);
+            fiber_stack_allocated(-bufferSize);
+        }
 
         // Allocate a new one of the appropriate size.
+        bufferSize = fiber_stack_buffer_size(stackDepth);
         f->stack_bottom = (uint32_t) malloc(bufferSize);
 
+        if (f->stack_bottom != 0)
+            fiber_stack_allocated(bufferSize);
+
         // Recalculate where the top of the stack is and we're done.
         f->stack_top = f->stack_bottom + bufferSize;
     }
+
+    return stackDepth;
+}
+
+/**
+  * Determines the address of the buffer a fiber's stack is paged out to when it is descheduled.
+  * Fibers with a dedicated stack are not paged at all.
+  *
+  * @param f The fiber context.
+  * @return The top of the fiber's stack buffer, or 0 if the fiber's stack is not paged.
+  */
+static inline uint32_t paged_stack(Fiber *f)
+{
+    return (f->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK) ? 0 : f->stack_top;
 }
 
 /**
@@ -598,7 +1089,364 @@ void verify_stack_size(Fiber *f)
   */
 int scheduler_runqueue_empty()
 {
-    return (runQueue == NULL);
+    return (highest_run_queue() == NULL);
+}
+
+/**
+  * Sets the priority of the currently running fiber.
+  * The new priority takes effect the next time the scheduler runs.
+  *
+  * @param priority The new priority, from FIBER_PRIORITY_LOW to FIBER_PRIORITY_HIGH.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if the priority is out of range.
+  */
+int fiber_set_priority(int priority)
+{
+    if (priority < 0 || priority >= FIBER_PRIORITY_LEVELS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    Fiber *f = currentFiber;
+
+    // Move to the run queue of the new priority. If we're not on a run queue (e.g. running in the context of the
+    // idle fiber), there's nothing else to do.
+    if (f->queue == run_queue(f))
+    {
+        dequeue_fiber(f);
+        f->priority = priority;
+        queue_fiber(f, run_queue(f));
+    }
+    else
+    {
+        f->priority = priority;
+    }
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Reads the scheduler statistics for the given priority level.
+  *
+  * @param priority The priority level, from FIBER_PRIORITY_LOW to FIBER_PRIORITY_HIGH.
+  * @param stats The structure to populate.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if the priority is out of range or stats is NULL.
+  */
+int scheduler_priority_statistics(int priority, FiberPriorityStatistics *stats)
+{
+    if (priority < 0 || priority >= FIBER_PRIORITY_LEVELS || stats == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    __disable_irq();
+    *stats = priorityStatistics[priority];
+    __enable_irq();
+
+    return MICROBIT_OK;
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Adds the fibers on the given queue to a snapshot of scheduler statistics.
+  * Must be called with interrupts disabled.
+  *
+  * @return The updated number of fibers in the snapshot.
+  */
+static int fiber_statistics_snapshot(Fiber *queue, Fiber **fibers, FiberStatistics *stats, int length, int count)
+{
+    for (Fiber *f = queue; f != NULL; f = f->next)
+    {
+        if (count < length)
+        {
+            if (fibers)
+                fibers[count] = f;
+
+            if (stats)
+            {
+                stats[count] = f->statistics;
+
+                // Include the time the running fiber has spent running so far.
+                if (f == currentFiber)
+                    stats[count].runTime += us_ticker_read() - f->statistics.scheduledAt;
+            }
+        }
+
+        count++;
+    }
+
+    return count;
+}
+#endif
+
+/**
+  * Takes a snapshot of the scheduler statistics of every fiber that is running, runnable, sleeping or waiting
+  * for an event (including the idle fiber). Requires MICROBIT_FIBER_STATISTICS to be enabled.
+  *
+  * @param fibers An array to populate with the fibers, or NULL.
+  * @param stats An array to populate with the statistics of each fiber, or NULL.
+  * @param length The length of the arrays.
+  * @return The number of fibers (which may be greater than length), or MICROBIT_NOT_SUPPORTED.
+  */
+int scheduler_fiber_statistics(Fiber **fibers, FiberStatistics *stats, int length)
+{
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    int count;
+
+    __disable_irq();
+
+    // The idle fiber doesn't live on any queue, so forms a queue of its own.
+    count = fiber_statistics_snapshot(idleFiber, fibers, stats, length, 0);
+
+    for (int i = FIBER_PRIORITY_LEVELS - 1; i >= 0; i--)
+        count = fiber_statistics_snapshot(runQueue[i], fibers, stats, length, count);
+
+    count = fiber_statistics_snapshot(sleepQueue, fibers, stats, length, count);
+
+    for (int i = 0; i < FIBER_WAIT_QUEUE_BUCKETS; i++)
+        count = fiber_statistics_snapshot(waitQueue[i], fibers, stats, length, count);
+
+    __enable_irq();
+
+    return count;
+#else
+    (void)fibers;
+    (void)stats;
+    (void)length;
+
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Writes the scheduler statistics of every fiber to the serial port, one line per fiber.
+  * Requires MICROBIT_FIBER_STATISTICS to be enabled.
+  *
+  * @return MICROBIT_OK, MICROBIT_NO_RESOURCES if there is insufficient memory to take a snapshot, or MICROBIT_NOT_SUPPORTED.
+  */
+int scheduler_fiber_statistics_dump()
+{
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    // Size the snapshot, allowing for a few more fibers to be created in the meantime.
+    int length = scheduler_fiber_statistics(NULL, NULL, 0) + 4;
+
+    Fiber **fibers = (Fiber **) malloc(length * sizeof(Fiber *));
+    FiberStatistics *stats = (FiberStatistics *) malloc(length * sizeof(FiberStatistics));
+
+    if (fibers == NULL || stats == NULL)
+    {
+        free(fibers);
+        free(stats);
+        return MICROBIT_NO_RESOURCES;
+    }
+
+    int count = min(scheduler_fiber_statistics(fibers, stats, length), length);
+
+    uBit.serial.printf("fiber      entry      flags pri run_us     switches max_latency_us max_stack\n");
+
+    for (int i = 0; i < count; i++)
+    {
+        uBit.serial.printf("0x%08x 0x%08x %c%c%c%c%c %d   %-10u %-8u %-14u %u\n",
+            (uint32_t) fibers[i], stats[i].entry,
+            fibers[i] == currentFiber ? 'R' : fibers[i] == idleFiber ? 'I' : '-',
+            fibers[i]->flags & MICROBIT_FIBER_FLAG_FOB ? 'F' : '-',
+            fibers[i]->flags & MICROBIT_FIBER_FLAG_PARENT ? 'P' : '-',
+            fibers[i]->flags & MICROBIT_FIBER_FLAG_CHILD ? 'C' : '-',
+            fibers[i]->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK ? 'D' : '-',
+            fibers[i]->priority, stats[i].runTime, stats[i].switches, stats[i].maxLatency, stats[i].maxStackDepth);
+    }
+
+    free(fibers);
+    free(stats);
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Reads the statistics of the fiber pool, including the high-water marks of fibers in use and stack buffer memory.
+  *
+  * @param stats The structure to populate.
+  * @return MICROBIT_OK, or MICROBIT_INVALID_PARAMETER if stats is NULL.
+  */
+int fiber_pool_statistics(FiberPoolStatistics *stats)
+{
+    if (stats == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    __disable_irq();
+
+    *stats = poolStatistics;
+
+    for (Fiber *f = fiberPool; f != NULL; f = f->next)
+    {
+        stats->pooled++;
+        stats->pooledBytes += sizeof(Fiber) + f->stack_top - f->stack_bottom;
+    }
+
+    for (Fiber *f = forkReserve; f != NULL; f = f->next)
+        stats->reservedBytes += sizeof(Fiber) + f->stack_top - f->stack_bottom;
+
+    __enable_irq();
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Records memory released by fiber_pool_trim() or fiber_stack_trim().
+  */
+static void fiber_trimmed(int bytes)
+{
+    if (bytes == 0)
+        return;
+
+    __disable_irq();
+
+    poolStatistics.trims++;
+    poolStatistics.trimmedBytes += bytes;
+
+    __enable_irq();
+}
+
+/**
+  * Releases unused fibers held in the fiber pool, along with their stack buffers, back to the heap.
+  * Fibers are pooled when they complete, so a burst of fibers otherwise holds on to its memory indefinitely.
+  * The fork on block reserve is left intact. Called automatically when the heap is exhausted if MICROBIT_FIBER_POOL_TRIM is enabled.
+  *
+  * @param keep The number of fibers to leave in the pool, to serve future fibers without allocating (defaults to 0).
+  * @return The number of bytes released, or MICROBIT_NOT_SUPPORTED if called from interrupt context.
+  */
+int fiber_pool_trim(int keep)
+{
+    int pooled = 0;
+    int released = 0;
+
+    // We may have interrupted release_fiber(), which pools the current fiber before it is descheduled.
+    if (inInterruptContext())
+        return MICROBIT_NOT_SUPPORTED;
+
+    __disable_irq();
+
+    for (Fiber *f = fiberPool; f != NULL; f = f->next)
+        if (f != currentFiber)
+            pooled++;
+
+    __enable_irq();
+
+    while (pooled-- > keep)
+    {
+        __disable_irq();
+
+        // Never release the fiber we're running on (or the stack beneath us).
+        Fiber *f = fiberPool;
+        if (f == currentFiber)
+            f = f->next;
+
+        // The pool may have been drained by an interrupt handler in the meantime.
+        if (f == NULL)
+        {
+            __enable_irq();
+            break;
+        }
+
+        dequeue_fiber(f);
+        // dequeue_fiber() exits with irqs enabled, so no need to do this again!
+
+        if (f->stack_bottom != 0)
+        {
+            free((void *)f->stack_bottom);
+            fiber_stack_allocated(f->stack_bottom - f->stack_top);
+            released += f->stack_top - f->stack_bottom;
+        }
+
+        delete f;
+        released += sizeof(Fiber);
+
+        __disable_irq();
+        poolStatistics.fibers--;
+        __enable_irq();
+    }
+
+    fiber_trimmed(released);
+
+    return released;
+}
+
+/**
+  * Finds a descheduled fiber on the given queue with a stack buffer larger than its stack needs.
+  * Must be called with interrupts disabled.
+  *
+  * @return The fiber, or NULL if there is none.
+  */
+static Fiber *find_oversized_stack(Fiber *queue)
+{
+    for (Fiber *f = queue; f != NULL; f = f->next)
+    {
+        if (f == currentFiber || f->stack_bottom == 0 || f->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK)
+            continue;
+
+        if (f->stack_top - f->stack_bottom > fiber_stack_buffer_size(f->tcb.stack_base - f->tcb.SP))
+            return f;
+    }
+
+    return NULL;
+}
+
+/**
+  * Shrinks the stack buffers of descheduled fibers that have grown larger than the stack they currently hold
+  * (e.g. after a single deep call), releasing the excess back to the heap. The buffer grows again if needed.
+  * Fibers with a dedicated stack are unaffected.
+  *
+  * @return The number of bytes released, or MICROBIT_NOT_SUPPORTED if called from interrupt context.
+  */
+int fiber_stack_trim()
+{
+    int released = 0;
+
+    // We may have interrupted the scheduler part way through paging a fiber in or out.
+    if (inInterruptContext())
+        return MICROBIT_NOT_SUPPORTED;
+
+    while (1)
+    {
+        Fiber *f = NULL;
+
+        // Interrupt handlers may move fibers between queues, so search for one fiber at a time.
+        // Descheduled fibers can't run until we're done with them, as we hold the processor.
+        __disable_irq();
+
+        for (int i = 0; i < FIBER_PRIORITY_LEVELS && f == NULL; i++)
+            f = find_oversized_stack(runQueue[i]);
+
+        if (f == NULL)
+            f = find_oversized_stack(sleepQueue);
+
+        for (int i = 0; i < FIBER_WAIT_QUEUE_BUCKETS && f == NULL; i++)
+            f = find_oversized_stack(waitQueue[i]);
+
+        __enable_irq();
+
+        if (f == NULL)
+            break;
+
+        // The paged stack is held at the top of the buffer, so move it to the top of the new one.
+        uint32_t stackDepth = f->tcb.stack_base - f->tcb.SP;
+        uint32_t bufferSize = fiber_stack_buffer_size(stackDepth);
+        uint32_t buffer = (uint32_t)(uintptr_t) malloc(bufferSize);
+
+        if (buffer == 0)
+            break;
+
+        memcpy((void *)(buffer + bufferSize - stackDepth), (void *)(f->stack_top - stackDepth), stackDepth);
+        free((void *)f->stack_bottom);
+
+        released += f->stack_top - f->stack_bottom - bufferSize;
+        fiber_stack_allocated(bufferSize - (f->stack_top - f->stack_bottom));
+
+        f->stack_bottom = buffer;
+        f->stack_top = buffer + bufferSize;
+    }
+
+    fiber_trimmed(released);
+
+    return released;
 }
 
 /**
@@ -611,6 +1459,11 @@ void schedule()
     // First, take a reference to the currently running fiber;
     Fiber *oldFiber = currentFiber;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS) || CONFIG_ENABLED(MICROBIT_TRACE)
+    // The fiber that was last accounted as running, which differs from oldFiber if we idle in place below.
+    Fiber *runningFiber = oldFiber;
+#endif
+
     // First, see if we're in Fork on Block context. If so, we simply want to store the full context
     // of the currently running thread in a newly created fiber, and restore the context of the
     // currently running fiber, back to the point where it entered FOB.
@@ -624,8 +1477,16 @@ void schedule()
         // Define the stack base of the forked fiber to be align with the entry point of the parent fiber
         forkedFiber->tcb.stack_base = currentFiber->tcb.SP;
 
-        // Ensure the stack allocation of the new fiber is large enough
-        verify_stack_size(forkedFiber);
+        // Ensure the stack allocation of the new fiber is large enough, and record how deep forks go.
+        // Fibers in the fork on block reserve are sized to match.
+        uint32_t stackBottom = forkedFiber->stack_bottom;
+        uint32_t stackDepth = verify_stack_size(forkedFiber);
+
+        if (stackDepth > poolStatistics.maxForkStackDepth)
+            poolStatistics.maxForkStackDepth = stackDepth;
+
+        if (forkedFiber->stack_bottom != stackBottom)
+            poolStatistics.forkStackGrows++;
 
         // Store the full context of this fiber.
         save_context(&forkedFiber->tcb, forkedFiber->stack_top);
@@ -641,18 +1502,21 @@ void schedule()
         return;
     }
 
-    // We're in a normal scheduling context, so perform a round robin algorithm across runnable fibers.
+    // We're in a normal scheduling context, so perform a round robin algorithm across the runnable fibers
+    // of the highest priority.
+    Fiber **queue = highest_run_queue();
+
     // OK - if we've nothing to do, then run the IDLE task (power saving sleep)
-    if (runQueue == NULL || fiber_flags & MICROBIT_FLAG_DATA_READY)
+    if (queue == NULL || fiber_flags & MICROBIT_FLAG_DATA_READY)
         currentFiber = idleFiber;
 
-    else if (currentFiber->queue == &runQueue)
-        // If the current fiber is on the run queue, round robin.
-        currentFiber = currentFiber->next == NULL ? runQueue : currentFiber->next;
+    else if (currentFiber->queue == queue)
+        // If the current fiber is on that run queue, round robin.
+        currentFiber = currentFiber->next == NULL ? *queue : currentFiber->next;
 
     else
         // Otherwise, just pick the head of the run queue.
-        currentFiber = runQueue;
+        currentFiber = *queue;
 
     if (currentFiber == idleFiber && oldFiber->flags & MICROBIT_FIBER_FLAG_DO_NOT_PAGE)
     {
@@ -663,17 +1527,42 @@ void schedule()
         // as we are running on top of this fiber's stack.
         currentFiber = oldFiber;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS) || CONFIG_ENABLED(MICROBIT_TRACE)
+        // Account for the time spent here as time spent in the idle fiber.
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        fiber_statistics_switch(oldFiber, idleFiber);
+#endif
+        fiber_trace_switch(oldFiber, idleFiber);
+        runningFiber = idleFiber;
+#endif
+
         do
         {
             idle();
         }
-        while (runQueue == NULL || fiber_flags & MICROBIT_FLAG_DATA_READY);
+        while (scheduler_runqueue_empty() || fiber_flags & MICROBIT_FLAG_DATA_READY);
 
         // Switch to a non-idle fiber.
         // If this fiber is the same as the old one then there'll be no switching at all.
-        currentFiber = runQueue;
+        currentFiber = *highest_run_queue();
     }
 
+    if (currentFiber != idleFiber)
+    {
+        priorityStatistics[currentFiber->priority].scheduled++;
+        prioritiesScheduled |= 1 << currentFiber->priority;
+    }
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS) || CONFIG_ENABLED(MICROBIT_TRACE)
+    if (currentFiber != runningFiber)
+    {
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        fiber_statistics_switch(runningFiber, currentFiber);
+#endif
+        fiber_trace_switch(runningFiber, currentFiber);
+    }
+#endif
+
     // Swap to the context of the chosen fiber, and we're done.
     // Don't bother with the overhead of switching if there's only one fiber on the runqueue!
     if (currentFiber != oldFiber)
@@ -688,15 +1577,32 @@ void schedule()
         if (oldFiber == idleFiber)
         {
             // Just swap in the new fiber, and discard changes to stack and register context.
-            swap_context(NULL, &currentFiber->tcb, 0, currentFiber->stack_top);
+            swap_context(NULL, &currentFiber->tcb, 0, paged_stack(currentFiber));
         }
         else
         {
-            // Ensure the stack allocation of the fiber being scheduled out is large enough
-            verify_stack_size(oldFiber);
+            // A fiber that has completed has nothing worth paging out.
+            int completed = oldFiber->queue == &fiberPool || oldFiber->queue == &forkReserve;
+
+            if (oldFiber->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK)
+            {
+                // Nothing to page out, but check the fiber has stayed within its stack.
+                if (*((uint32_t *)oldFiber->stack_bottom) != MICROBIT_FIBER_STACK_CANARY)
+                    uBit.panic(MICROBIT_FIBER_STACK_OVERFLOW);
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+                if (oldFiber->tcb.stack_base - __get_MSP() > oldFiber->statistics.maxStackDepth)
+                    oldFiber->statistics.maxStackDepth = oldFiber->tcb.stack_base - __get_MSP();
+#endif
+            }
+            else if (!completed)
+            {
+                // Ensure the stack allocation of the fiber being scheduled out is large enough
+                verify_stack_size(oldFiber);
+            }
 
             // Schedule in the new fiber.
-            swap_context(&oldFiber->tcb, &currentFiber->tcb, oldFiber->stack_top, currentFiber->stack_top);
+            swap_context(&oldFiber->tcb, &currentFiber->tcb, completed ? 0 : paged_stack(oldFiber), paged_stack(currentFiber));
         }
     }
 }
@@ -714,10 +1620,24 @@ void idle()
     // If the above did create any useful work, enter power efficient sleep.
     if(scheduler_runqueue_empty())
     {
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+        // No fiber is running, so take the opportunity to gather up the free space in the heap.
+        microbit_heap_compact();
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_TICKLESS_IDLE)
+        // If nothing needs the system tick for a while, don't wake up for it.
+        uBit.suspendSystemTick();
+#endif
+
         if (uBit.ble)
             uBit.ble->waitForEvent();
         else
             __WFI();
+
+#if CONFIG_ENABLED(MICROBIT_TICKLESS_IDLE)
+        uBit.resumeSystemTick();
+#endif
     }
 }
 /**
@@ -22,18 +22,67 @@
   * P.S. This is a very simple allocator, therefore not without its weaknesses. Why don't you consider 
   * what these are, and consider the tradeoffs against simplicity...
   *
-  * TODO: Consider caching recently freed blocks to improve allocation time.
+  * Recently freed small blocks are cached on free lists, one per size class, in front of the heap
+  * (see MICROBIT_HEAP_SIZE_CLASSES).
+  *
+  * The payloads of ManagedString and MicroBitImage can also be allocated as relocatable blocks, which are
+  * referred to through a handle, and are moved together when the processor is idle to restore large
+  * contiguous free spaces (see MICROBIT_HEAP_RELOCATABLE).
   */
 struct HeapDefinition
 {
     uint32_t *heap_start;		// Physical address of the start of this heap.
     uint32_t *heap_end;		    // Physical address of the end of this heap.
+    uint32_t used;              // Number of blocks currently marked as used, including those held on free lists.
+    uint32_t peakUsed;          // The highest value of used seen so far.
+    uint32_t allocations;       // Number of allocations served from this heap.
+    uint32_t failures;          // Number of allocations this heap did not have space for.
 };
 
 // Create the necessary heap definitions.
 // We use two heaps by default: one for SoftDevice reuse, and one to run inside the mbed heap.
 HeapDefinition heap[MICROBIT_HEAP_COUNT] = { }; 
 
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+// The size of each size class in blocks, including the block header. Chosen to fit the most common allocations
+// closely, such as event queue items, listeners, short strings, packet buffers and fibers.
+const uint8_t heapSizeClass[MICROBIT_HEAP_SIZE_CLASS_COUNT] = { 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 28, 32 };
+
+// The free list of each size class. Blocks on a free list are still marked as used in the heap, so the
+// allocator leaves them alone. They are linked through their first word of data.
+uint32_t *heapFreeList[MICROBIT_HEAP_SIZE_CLASS_COUNT] = { };
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+// The handles of relocatable blocks. Each holds the current address of the memory of its block, and the last
+// word of the block holds the address of its handle, so the handle can be updated when the block is moved.
+static uint32_t heapHandleStorage[MICROBIT_POOL_STORAGE(sizeof(void *), MICROBIT_HEAP_HANDLES)];
+MicroBitPool heapHandlePool = { heapHandleStorage, MICROBIT_POOL_OBJECT_SIZE(sizeof(void *)), MICROBIT_HEAP_HANDLES };
+
+// Set when a block is returned to the heap, so there may be something for microbit_heap_compact() to do.
+bool heapCompactionDue = false;
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+struct HeapAllocationSite
+{
+    uint32_t address;           // The return address of the call that allocated the memory. Site 0 counts allocations from any sites that don't fit in the table.
+    uint32_t allocations;       // The number of allocations made from this site since profiling started.
+    uint32_t liveBlocks;        // The number of those allocations not yet freed.
+    uint32_t liveBytes;         // The memory held by those allocations, including the index block of each.
+    uint32_t peakBytes;         // The highest value of liveBytes seen since profiling started.
+    uint16_t minSize;           // The smallest and largest amount of memory requested since profiling started (bytes).
+    uint16_t maxSize;
+};
+
+// The allocation sites seen so far, filled in order from site 1. The site of each used block is held in its index block.
+HeapAllocationSite heapSites[MICROBIT_HEAP_PROFILE_SITES] = { };
+
+// The system time at which profiling started (ms).
+unsigned long heapProfileStart = 0;
+
+#endif
+
 // Scans the status of the heap definition table, and returns the number of INITIALISED heaps.
 int microbit_active_heaps()
 {
@@ -48,6 +97,86 @@ int microbit_active_heaps()
     return heapCount;
 }
 
+/**
+  * Determines which of our heaps a block of memory was allocated from.
+  * @param block The index block of the memory.
+  * @return The heap holding the block, or NULL if the block is not part of any registered heap.
+  */
+HeapDefinition *microbit_heap_of(uint32_t *block)
+{
+    for (int i=0; i < MICROBIT_HEAP_COUNT; i++)
+    {
+        if(block >= heap[i].heap_start && block < heap[i].heap_end)
+            return &heap[i];
+    }
+
+    return NULL;
+}
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+/**
+  * Records an allocation in the heap profile, and tags its block with the site it was allocated from.
+  * @param mem The memory allocated. Memory from the native heap is not profiled.
+  * @param size The amount of memory requested, in bytes.
+  * @param address The return address of the call to the allocator.
+  */
+void microbit_heap_profile_allocation(void *mem, size_t size, void *address)
+{
+    uint32_t *cb = (uint32_t *)mem - 1;
+    int site = 1;
+
+    if (mem == NULL || microbit_heap_of(cb) == NULL)
+        return;
+
+    size = min(size, (size_t) 0xFFFF);
+
+    __disable_irq();
+
+    while (site < MICROBIT_HEAP_PROFILE_SITES && heapSites[site].address != 0 && heapSites[site].address != (uint32_t) address)
+        site++;
+
+    if (site == MICROBIT_HEAP_PROFILE_SITES)
+        site = 0;
+    else
+        heapSites[site].address = (uint32_t) address;
+
+    HeapAllocationSite &s = heapSites[site];
+
+    if (s.allocations++ == 0 || size < s.minSize)
+        s.minSize = size;
+
+    if (size > s.maxSize)
+        s.maxSize = size;
+
+    s.liveBlocks++;
+    s.liveBytes += (*cb & ~MICROBIT_HEAP_BLOCK_FLAGS) * MICROBIT_HEAP_BLOCK_SIZE;
+
+    if (s.liveBytes > s.peakBytes)
+        s.peakBytes = s.liveBytes;
+
+    *cb |= site << MICROBIT_HEAP_BLOCK_SITE_SHIFT;
+
+    __enable_irq();
+}
+
+/**
+  * Records a block being freed in the heap profile, and removes the tag of its allocation site.
+  * @param cb The index block of the memory being freed.
+  */
+void microbit_heap_profile_release(uint32_t *cb)
+{
+    __disable_irq();
+
+    HeapAllocationSite &s = heapSites[(*cb & MICROBIT_HEAP_BLOCK_SITE) >> MICROBIT_HEAP_BLOCK_SITE_SHIFT];
+
+    s.liveBlocks--;
+    s.liveBytes -= (*cb & ~MICROBIT_HEAP_BLOCK_FLAGS) * MICROBIT_HEAP_BLOCK_SIZE;
+    *cb &= ~MICROBIT_HEAP_BLOCK_SITE;
+
+    __enable_irq();
+}
+#endif
+
 #if CONFIG_ENABLED(MICROBIT_DBG) && CONFIG_ENABLED(MICROBIT_HEAP_DBG)
 
 // Internal diagnostics function.
@@ -76,7 +205,7 @@ void microbit_heap_print(HeapDefinition &heap)
 	block = heap.heap_start;
 	while (block < heap.heap_end)
 	{
-		blockSize = *block & ~MICROBIT_HEAP_BLOCK_FREE;
+		blockSize = *block & ~MICROBIT_HEAP_BLOCK_FLAGS;
         uBit.serial.printf("[%C:%d] ", *block & MICROBIT_HEAP_BLOCK_FREE ? 'F' : 'U', blockSize*4);
         if (cols++ == 20)
         {
@@ -255,7 +384,7 @@ void *microbit_malloc(size_t size, HeapDefinition &heap)
 		// If the block is used, then keep looking.
 		if(!(*block & MICROBIT_HEAP_BLOCK_FREE))
 		{
-			block += *block;
+			block += *block & ~MICROBIT_HEAP_BLOCK_FLAGS;
 			continue;
 		}
 
@@ -288,6 +417,7 @@ void *microbit_malloc(size_t size, HeapDefinition &heap)
 	// We're full!
 	if (block >= heap.heap_end)
     {
+        heap.failures++;
         __enable_irq();
         return NULL;
     }
@@ -308,21 +438,133 @@ void *microbit_malloc(size_t size, HeapDefinition &heap)
 		*block = blocksNeeded;
 	}
 
+    // Keep our statistics up to date, while we still have interrupts disabled.
+    heap.used += *block;
+    heap.allocations++;
+
+    if (heap.used > heap.peakUsed)
+        heap.peakUsed = heap.used;
+
 	// Enable Interrupts
     __enable_irq();
 
 	return block+1;
 }
 
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
 /**
-  * Attempt to allocate a given amount of memory from any of our configured heap areas.
+  * Determines the size class to allocate a given amount of memory from.
+  * @param size The amount of memory, in bytes.
+  * @return The smallest size class large enough, or -1 if there is none.
+  */
+int microbit_heap_size_class(size_t size)
+{
+    // Account for the index block.
+    uint32_t blocksNeeded = (size + MICROBIT_HEAP_BLOCK_SIZE - 1) / MICROBIT_HEAP_BLOCK_SIZE + 1;
+
+    for (int i = 0; i < MICROBIT_HEAP_SIZE_CLASS_COUNT; i++)
+        if (heapSizeClass[i] >= blocksNeeded)
+            return i;
+
+    return -1;
+}
+
+/**
+  * Determines the size class whose free list a freed block can join.
+  * @param blockSize The size of the block, including the index block.
+  * @return The largest size class that fits in the block, or -1 if the block is too large for any size class.
+  */
+int microbit_heap_free_list(uint32_t blockSize)
+{
+    if (blockSize > heapSizeClass[MICROBIT_HEAP_SIZE_CLASS_COUNT - 1])
+        return -1;
+
+    for (int i = MICROBIT_HEAP_SIZE_CLASS_COUNT - 1; i >= 0; i--)
+        if (heapSizeClass[i] <= blockSize)
+            return i;
+
+    return -1;
+}
+
+/**
+  * Returns every block held on the size class free lists to the heap.
+  * @return The number of blocks returned.
+  */
+int microbit_heap_flush_free_lists()
+{
+    int released = 0;
+
+    for (int i = 0; i < MICROBIT_HEAP_SIZE_CLASS_COUNT; i++)
+    {
+        // Take the whole list, then mark each block as free at our leisure.
+        __disable_irq();
+
+        uint32_t *block = heapFreeList[i];
+        heapFreeList[i] = NULL;
+
+        __enable_irq();
+
+        while (block != NULL)
+        {
+            uint32_t *next = (uint32_t *) block[1];
+            HeapDefinition *h = microbit_heap_of(block);
+
+            __disable_irq();
+
+            h->used -= *block;
+            *block |= MICROBIT_HEAP_BLOCK_FREE;
+
+            __enable_irq();
+
+            released++;
+            block = next;
+        }
+    }
+
+    return released;
+}
+#endif
+
+/**
+  * Attempt to allocate a given amount of memory from any of our configured heap areas, falling back to the native heap.
   * @param size The amount of memory, in bytes, to allocate.
   * @return A pointer to the allocated memory, or NULL if insufficient memory is available.
   */
-void *microbit_malloc(size_t size)
+static void *microbit_heap_allocate(size_t size)
 {
     void *p;
 
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+    int sizeClass = size > 0 ? microbit_heap_size_class(size) : -1;
+
+    if (sizeClass >= 0)
+    {
+        // If we have a block of this size class to hand, we're done.
+        __disable_irq();
+
+        uint32_t *block = heapFreeList[sizeClass];
+
+        if (block != NULL)
+        {
+            heapFreeList[sizeClass] = (uint32_t *) block[1];
+            microbit_heap_of(block)->allocations++;
+        }
+
+        __enable_irq();
+
+        if (block != NULL)
+        {
+#if CONFIG_ENABLED(MICROBIT_DBG) && CONFIG_ENABLED(MICROBIT_HEAP_DBG)
+            uBit.serial.printf("microbit_malloc: ALLOCATED: %d [%p]\n", size, block+1);
+#endif    
+            return block+1;
+        }
+
+        // Otherwise, allocate a whole block of the size class, so it can join the free list when it is freed.
+        size = (heapSizeClass[sizeClass] - 1) * MICROBIT_HEAP_BLOCK_SIZE;
+    }
+#endif
+
     // Assign the memory from the first heap created that has space.
     for (int i=0; i < MICROBIT_HEAP_COUNT; i++)
     {
@@ -339,6 +581,19 @@ void *microbit_malloc(size_t size)
         }
     }
 
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+    // Blocks held on the free lists may be enough to satisfy us, once returned to the heap.
+    if (microbit_heap_flush_free_lists() > 0)
+        return microbit_heap_allocate(size);
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_POOL_TRIM)
+    // Unused fibers may be holding on to memory after a burst of activity. If so, release them and try again.
+    // fiber_pool_trim() declines to run in interrupt context, where it could race with the scheduler.
+    if (microbit_active_heaps() && fiber_pool_trim() > 0)
+        return microbit_heap_allocate(size);
+#endif
+
     // If we reach here, then either we have no memory available, or our heap spaces
     // haven't been initialised. Either way, we try the native allocator.
 
@@ -361,12 +616,34 @@ void *microbit_malloc(size_t size)
 #endif    
     
 #if CONFIG_ENABLED(MICROBIT_PANIC_HEAP_FULL)
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+    // Show where our memory went.
+    if (microbit_active_heaps())
+        microbit_heap_profile_dump(MICROBIT_HEAP_PROFILE_SITES);
+#endif
+
     panic(MICROBIT_OOM);
 #endif        
 
     return NULL;
 }
 
+/**
+  * Attempt to allocate a given amount of memory from any of our configured heap areas.
+  * @param size The amount of memory, in bytes, to allocate.
+  * @return A pointer to the allocated memory, or NULL if insufficient memory is available.
+  */
+void *microbit_malloc(size_t size)
+{
+    void *p = microbit_heap_allocate(size);
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+    microbit_heap_profile_allocation(p, size, __builtin_return_address(0));
+#endif
+
+    return p;
+}
+
 /**
   * Release a given area of memory from the heap. 
   * @param mem The memory area to release.
@@ -389,9 +666,55 @@ void microbit_free(void *mem)
     {
         if(memory > heap[i].heap_start && memory < heap[i].heap_end)
         {
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+            microbit_heap_profile_release(cb);
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+            // If the block is small enough, keep it on the free list of its size class for reuse. Relocatable blocks
+            // go straight back to the heap instead, where compaction can make use of the space.
+            int sizeClass = (*cb & MICROBIT_HEAP_BLOCK_RELOCATABLE) ? -1 : microbit_heap_free_list(*cb);
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+            // A relocatable block gives up its handle, then is freed like any other block.
+            if (*cb & MICROBIT_HEAP_BLOCK_RELOCATABLE)
+            {
+                __disable_irq();
+
+                heapHandlePool.release((void *) cb[(*cb & ~MICROBIT_HEAP_BLOCK_FLAGS) - 1]);
+                *cb &= ~MICROBIT_HEAP_BLOCK_FLAGS;
+
+                __enable_irq();
+            }
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+            if (sizeClass >= 0)
+            {
+                __disable_irq();
+
+                *memory = (uint32_t)(uintptr_t) heapFreeList[sizeClass];
+                heapFreeList[sizeClass] = cb;
+
+                __enable_irq();
+
+                return;
+            }
+#endif
+
             // The memory block given is part of this heap, so we can simply
 	        // flag that this memory area is now free, and we're done.
+            __disable_irq();
+
+            heap[i].used -= *cb;
 	        *cb |= MICROBIT_HEAP_BLOCK_FREE;
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+            heapCompactionDue = true;
+#endif
+
+            __enable_irq();
             return;
         }
     }
@@ -401,3 +724,331 @@ void microbit_free(void *mem)
     native_free(mem);
 }
 
+/**
+  * Attempt to allocate a given amount of memory as a relocatable block, which microbit_heap_compact() may move
+  * elsewhere in the heap. The block is referred to through a handle, which always holds its current address
+  * (see microbit_heap_handle()). Requires MICROBIT_HEAP_RELOCATABLE to be enabled: otherwise, or if we run out
+  * of handles or heap space, this is the same as microbit_malloc(). Either way, the memory is released with microbit_free().
+  *
+  * @param size The amount of memory, in bytes, to allocate.
+  * @return A pointer to the allocated memory, or NULL if insufficient memory is available.
+  */
+void *microbit_malloc_relocatable(size_t size)
+{
+    void *p = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+    void **handle = size > 0 ? (void **) heapHandlePool.allocate() : NULL;
+
+    if (handle != NULL)
+    {
+        // Relocatable blocks bypass the size class free lists, and have an extra word at the end for the address of their handle.
+        for (int i=0; i < MICROBIT_HEAP_COUNT; i++)
+        {
+            if(heap[i].heap_start != NULL)
+            {
+                uint32_t *memory = (uint32_t *) microbit_malloc(size + MICROBIT_HEAP_BLOCK_SIZE, heap[i]);
+
+                if (memory != NULL)
+                {
+                    uint32_t *cb = memory-1;
+
+                    *handle = memory;
+                    cb[*cb - 1] = (uint32_t)(uintptr_t) handle;
+                    *cb |= MICROBIT_HEAP_BLOCK_RELOCATABLE;
+
+                    p = memory;
+                    break;
+                }
+            }
+        }
+
+        if (p == NULL)
+            heapHandlePool.release(handle);
+    }
+#endif
+
+    if (p == NULL)
+        p = microbit_heap_allocate(size);
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+    microbit_heap_profile_allocation(p, size, __builtin_return_address(0));
+#endif
+
+    return p;
+}
+
+/**
+  * Determines the handle of a relocatable block.
+  * @param mem The memory allocated, as returned by microbit_malloc_relocatable().
+  * @return The handle of the block, holding its current address, or NULL if the memory is not a relocatable block.
+  */
+void **microbit_heap_handle(void *mem)
+{
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+    uint32_t *cb = (uint32_t *)mem - 1;
+
+    if (microbit_heap_of(cb) != NULL && (*cb & MICROBIT_HEAP_BLOCK_RELOCATABLE))
+        return (void **) cb[(*cb & ~MICROBIT_HEAP_BLOCK_FLAGS) - 1];
+#endif
+
+    return NULL;
+}
+
+/**
+  * Fixes a relocatable block where it is for the rest of its life, so it is safe to refer to it by its address
+  * (e.g. from code outside the runtime). Does nothing to other memory.
+  * @param mem The memory to pin.
+  */
+void microbit_heap_pin(void *mem)
+{
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+    uint32_t *cb = (uint32_t *)mem - 1;
+
+    if (microbit_heap_of(cb) != NULL)
+    {
+        __disable_irq();
+
+        if (*cb & MICROBIT_HEAP_BLOCK_RELOCATABLE)
+            *cb |= MICROBIT_HEAP_BLOCK_PINNED;
+
+        __enable_irq();
+    }
+#endif
+}
+
+/**
+  * Defragments our heaps, by sliding relocatable blocks down into any free space below them and updating their
+  * handles, so the free space between them gathers into larger contiguous blocks. Pinned and non-relocatable
+  * blocks stay where they are. Does nothing unless memory has been freed since the heaps were last compacted.
+  *
+  * This is called by the scheduler whenever the processor is idle. Any raw pointer into a relocatable block
+  * (e.g. from ManagedString::toCharArray()) held across a call is left dangling, so such pointers must not be
+  * kept by a fiber beyond the point at which it next blocks.
+  *
+  * @return The number of bytes moved, or MICROBIT_NOT_SUPPORTED if MICROBIT_HEAP_RELOCATABLE is not enabled.
+  */
+int microbit_heap_compact()
+{
+#if CONFIG_ENABLED(MICROBIT_HEAP_RELOCATABLE)
+    int moved = 0;
+
+    if (!heapCompactionDue)
+        return 0;
+
+    heapCompactionDue = false;
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+    // Blocks cached on the free lists can't move, so would otherwise stop anything above them from sliding down.
+    microbit_heap_flush_free_lists();
+#endif
+
+    for (int i=0; i < MICROBIT_HEAP_COUNT; i++)
+    {
+        HeapDefinition &h = heap[i];
+        uint32_t *block = h.heap_start;
+        uint32_t *space = NULL;
+        uint32_t allocations = h.allocations;
+
+        if (h.heap_start == NULL)
+            continue;
+
+        // Walk the heap one block at a time, so interrupts are only ever held off for as long as it takes to move a single block.
+        while (block < h.heap_end)
+        {
+            __disable_irq();
+
+            // An allocation made from interrupt context may have taken the free space we're holding on to.
+            if (h.allocations != allocations)
+            {
+                allocations = h.allocations;
+                space = NULL;
+            }
+
+            uint32_t blockSize = *block & ~MICROBIT_HEAP_BLOCK_FLAGS;
+
+            if (*block & MICROBIT_HEAP_BLOCK_FREE)
+            {
+                // The free space below the next block starts here, unless it started further down.
+                if (space == NULL)
+                    space = block;
+            }
+            else if (space != NULL && (*block & (MICROBIT_HEAP_BLOCK_RELOCATABLE | MICROBIT_HEAP_BLOCK_PINNED)) == MICROBIT_HEAP_BLOCK_RELOCATABLE)
+            {
+                // Slide the block down to the start of the free space, and tell its handle where it now lives.
+                memmove(space, block, blockSize * MICROBIT_HEAP_BLOCK_SIZE);
+                *(void **) space[blockSize - 1] = space + 1;
+
+                // The free space now starts just above the block, and takes in the space the block left behind.
+                space += blockSize;
+                *space = (block + blockSize - space) | MICROBIT_HEAP_BLOCK_FREE;
+
+                moved += blockSize * MICROBIT_HEAP_BLOCK_SIZE;
+            }
+            else
+            {
+                // This block can't move, so nothing above it can move below it.
+                space = NULL;
+            }
+
+            block += blockSize;
+
+            __enable_irq();
+        }
+    }
+
+    return moved;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Reports the health of one of our heaps: how much memory is free, how fragmented that memory is, and
+  * how busy the heap has been. This walks the heap once with interrupts disabled, which costs about the
+  * same as an allocation that has to search the whole heap, so is cheap enough to poll periodically.
+  *
+  * @param index The heap to report on: 0 for the heap nested inside the mbed heap, 1 for the heap
+  * reusing SoftDevice memory.
+  * @param stats The structure to fill in.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if stats is NULL or the given heap does not exist.
+  */
+int microbit_heap_statistics(int index, HeapStatistics *stats)
+{
+    if (index < 0 || index >= MICROBIT_HEAP_COUNT || stats == NULL || heap[index].heap_start == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    HeapDefinition &h = heap[index];
+    uint32_t    *block;
+    uint32_t    blockSize;
+    uint32_t    freeBlocks = 0;
+    uint32_t    largestFree = 0;
+    uint32_t    run = 0;
+    uint32_t    cached = 0;
+
+    // Disable IRQ temporarily to ensure no race conditions!
+    __disable_irq();
+
+    // Adjacent free blocks are only merged when an allocation passes over them, so measure contiguous runs.
+    block = h.heap_start;
+    while (block < h.heap_end)
+    {
+        blockSize = *block & ~MICROBIT_HEAP_BLOCK_FLAGS;
+
+        if (*block & MICROBIT_HEAP_BLOCK_FREE)
+        {
+            freeBlocks += blockSize;
+            run += blockSize;
+
+            if (run > largestFree)
+                largestFree = run;
+        }
+        else
+        {
+            run = 0;
+        }
+
+        block += blockSize;
+    }
+
+#if CONFIG_ENABLED(MICROBIT_HEAP_SIZE_CLASSES)
+    for (int i = 0; i < MICROBIT_HEAP_SIZE_CLASS_COUNT; i++)
+        for (block = heapFreeList[i]; block != NULL; block = (uint32_t *) block[1])
+            if (block >= h.heap_start && block < h.heap_end)
+                cached += *block;
+#endif
+
+    stats->used = (h.used - cached) * MICROBIT_HEAP_BLOCK_SIZE;
+    stats->peakUsed = h.peakUsed * MICROBIT_HEAP_BLOCK_SIZE;
+    stats->allocations = h.allocations;
+    stats->failures = h.failures;
+
+    // Enable Interrupts
+    __enable_irq();
+
+    stats->size = (uint32_t)(uintptr_t) h.heap_end - (uint32_t)(uintptr_t) h.heap_start;
+    stats->totalFree = (freeBlocks + cached) * MICROBIT_HEAP_BLOCK_SIZE;
+    stats->largestFree = largestFree * MICROBIT_HEAP_BLOCK_SIZE;
+    stats->cached = cached * MICROBIT_HEAP_BLOCK_SIZE;
+    stats->fragmentation = freeBlocks ? 100 - (largestFree * 100) / freeBlocks : 0;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Writes the allocation sites holding the most memory to the serial port, in the format read by the
+  * heap-profile-decoder host tool. Requires MICROBIT_HEAP_PROFILE to be enabled.
+  *
+  * @param sites The most sites to write out.
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_heap_profile_dump(int sites)
+{
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+    uint8_t order[MICROBIT_HEAP_PROFILE_SITES];
+    int count = 0;
+
+    // Order the sites seen by the memory they hold, most first. Site 0 is only of interest if the table overflowed.
+    for (int i = 0; i < MICROBIT_HEAP_PROFILE_SITES; i++)
+    {
+        if (i == 0 ? heapSites[0].allocations == 0 && heapSites[0].liveBlocks == 0 : heapSites[i].address == 0)
+            continue;
+
+        int j = count++;
+
+        while (j > 0 && heapSites[order[j-1]].liveBytes < heapSites[i].liveBytes)
+        {
+            order[j] = order[j-1];
+            j--;
+        }
+
+        order[j] = i;
+    }
+
+    sites = max(0, min(sites, count));
+
+    uBit.serial.printf("heap profile %x %x %x\n", sites, count, uBit.systemTime() - heapProfileStart);
+
+    for (int i = 0; i < sites; i++)
+    {
+        HeapAllocationSite s = heapSites[order[i]];
+
+        uBit.serial.printf("%x %x %x %x %x %x %x\n", s.address, s.allocations, s.liveBlocks, s.liveBytes, s.peakBytes, s.minSize, s.maxSize);
+    }
+
+    uBit.serial.printf("heap profile end\n");
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Restarts the heap profile: the allocation count, peak and size range of each site are reset, and allocation
+  * rates are measured from now. The memory held by each site is still tracked. Requires MICROBIT_HEAP_PROFILE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_heap_profile_clear()
+{
+#if CONFIG_ENABLED(MICROBIT_HEAP_PROFILE)
+    __disable_irq();
+
+    for (int i = 0; i < MICROBIT_HEAP_PROFILE_SITES; i++)
+    {
+        heapSites[i].allocations = 0;
+        heapSites[i].peakBytes = heapSites[i].liveBytes;
+        heapSites[i].minSize = 0;
+        heapSites[i].maxSize = 0;
+    }
+
+    heapProfileStart = uBit.systemTime();
+
+    __enable_irq();
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
@@ -190,6 +190,7 @@ MicroBitImage::MicroBitImage(ImageData *p)
 ImageData *MicroBitImage::leakData()
 {
     ImageData* res = ptr;
+    microbit_heap_pin(res);
     init_empty();
     return res;
 }
@@ -249,7 +250,7 @@ void MicroBitImage::init(const int16_t x, const int16_t y, const uint8_t *bitmap
 
     
     // Create a copy of the array
-    ptr = (ImageData*)malloc(sizeof(ImageData) + x * y);
+    ptr = (ImageData*)microbit_malloc_relocatable(sizeof(ImageData) + x * y);
     ptr->init();
     ptr->width = x;
     ptr->height = y;
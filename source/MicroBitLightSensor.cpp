@@ -48,7 +48,7 @@ void MicroBitLightSensor::analogDisable()
 
 /**
   * The method that is invoked by sending MICROBIT_DISPLAY_EVT_LIGHT_SENSE
-  * using the id MICROBIT_ID_DISPLAY.
+  * using the id MICROBIT_ID_DISPLAY (see MicroBitDisplay::onLightSenseEvent()).
   *
   * If you want to manually trigger this method, you should use the event bus.
   *
@@ -82,8 +82,6 @@ MicroBitLightSensor::MicroBitLightSensor() : analogTrigger()
 {
     this->chan = 0;
 
-    uBit.MessageBus.listen(MICROBIT_ID_DISPLAY, MICROBIT_DISPLAY_EVT_LIGHT_SENSE, this, &MicroBitLightSensor::startSensing, MESSAGE_BUS_LISTENER_IMMEDIATE);
-
     this->sensePin = NULL;
 }
 
@@ -138,10 +136,8 @@ int MicroBitLightSensor::read()
 
 
 /**
-  * The destructor restores the default Display Mode and tick speed, and also
-  * removes the listener from the MessageBus.
+  * Destructor.
   */
 MicroBitLightSensor::~MicroBitLightSensor()
 {
-    uBit.MessageBus.ignore(MICROBIT_ID_DISPLAY, MICROBIT_DISPLAY_EVT_LIGHT_SENSE, this, &MicroBitLightSensor::startSensing);
 }
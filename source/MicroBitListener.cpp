@@ -8,6 +8,10 @@
 #include "mbed.h"
 #include "MicroBit.h"
 
+static uint32_t listenerStorage[MICROBIT_POOL_STORAGE(sizeof(MicroBitListener), MESSAGE_BUS_LISTENER_POOL_SIZE)];
+
+MicroBitPool listenerPool = { listenerStorage, MICROBIT_POOL_OBJECT_SIZE(sizeof(MicroBitListener)), MESSAGE_BUS_LISTENER_POOL_SIZE };
+
 /**
   * Constructor. 
   * Create a new Message Bus Listener.
@@ -15,7 +19,7 @@
   * @param value The event ID you would like to listen to from that component
   * @param handler A function pointer to call when the event is detected.
   */
-MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent), uint16_t flags)
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent), uint32_t flags)
 {
 	this->id = id;
 	this->value = value;
@@ -24,6 +28,8 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
     this->flags = flags;
 	this->next = NULL;
     this->evt_queue = NULL;
+    this->queueLength = 0;
+    this->queueCapacity = MESSAGE_BUS_LISTENER_CAPACITY_OF(flags);
 }
 
 /**
@@ -34,7 +40,7 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
   * @param handler A function pointer to call when the event is detected.
   * @param arg An additional argument to pass to the event handler function.
   */
-MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent, void *), void* arg, uint16_t flags)
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent, void *), void* arg, uint32_t flags)
 {
 	this->id = id;
 	this->value = value;
@@ -43,6 +49,28 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
     this->flags = flags | MESSAGE_BUS_LISTENER_PARAMETERISED;
 	this->next = NULL;
     this->evt_queue = NULL;
+    this->queueLength = 0;
+    this->queueCapacity = MESSAGE_BUS_LISTENER_CAPACITY_OF(flags);
+}
+
+/**
+  * Constructor.
+  * Create a new batched Message Bus Listener.
+  * @param id The ID of the component you want to listen to.
+  * @param value The event ID you would like to listen to from that component.
+  * @param handler A function pointer to call with the events gathered, and their number.
+  */
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent *, int), uint32_t flags)
+{
+	this->id = id;
+	this->value = value;
+	this->cb_batch = handler;
+	this->cb_arg = NULL;
+    this->flags = flags | MESSAGE_BUS_LISTENER_BATCH;
+	this->next = NULL;
+    this->evt_queue = NULL;
+    this->queueLength = 0;
+    this->queueCapacity = MESSAGE_BUS_LISTENER_CAPACITY_OF(flags);
 }
 
 /**
@@ -52,31 +80,144 @@ MicroBitListener::~MicroBitListener()
 {
     if(this->flags & MESSAGE_BUS_LISTENER_METHOD)
         delete cb_method;
+
+    MicroBitEvent e;
+
+    while (dequeue(e));
 }
 
 /**
-  * Queues and event up to be processed.
-  * @param e The event to queue
+  * Restricts this listener to the events described by the given filter, in place of its ID and value.
+  * @param filter The events of interest.
   */
-void MicroBitListener::queue(MicroBitEvent e)
+void MicroBitListener::setFilter(const MicroBitEventFilter &filter)
 {
-    int queueDepth;
+    // Wildcards are simply the widest possible range.
+    this->id = filter.id;
+    this->idTo = filter.id == MICROBIT_ID_ANY ? 0xFFFF : filter.idTo;
+    this->value = filter.value;
+    this->valueTo = filter.value == MICROBIT_EVT_ANY ? 0xFFFF : filter.valueTo;
+    this->flags |= MESSAGE_BUS_LISTENER_FILTERED;
 
-    MicroBitEventQueueItem *p = evt_queue;
+    // A set of values is matched as the range between the lowest and highest values in the set, then the set itself.
+    if (filter.valueMask)
+    {
+        this->value = 0;
+        this->valueTo = 15;
 
-    if (evt_queue == NULL)
-        evt_queue = new MicroBitEventQueueItem(e);
-    else
+        while (!(filter.valueMask & MICROBIT_EVT_MASK(this->value)))
+            this->value++;
+
+        while (!(filter.valueMask & MICROBIT_EVT_MASK(this->valueTo)))
+            this->valueTo--;
+
+        this->valueMask = filter.valueMask;
+        this->flags |= MESSAGE_BUS_LISTENER_VALUE_MASK;
+    }
+}
+
+/**
+  * Queues and event up to be processed. Should the queue be full, either this event or the oldest is dropped,
+  * depending on MESSAGE_BUS_LISTENER_DROP_OLDEST. With MESSAGE_BUS_LISTENER_COALESCE, an event instead replaces
+  * any queued event with the same source and value.
+  * @param e The event to queue
+  * @return The number of events now queued.
+  */
+int MicroBitListener::queue(MicroBitEvent e)
+{
+    MicroBitEventQueueItem *item;
+
+    if ((flags & MESSAGE_BUS_LISTENER_COALESCE) && evt_queue != NULL)
     {
-        queueDepth = 1;
+        item = evt_queue;
+
+        do
+        {
+            item = item->next;
+
+            if (item->evt.source == e.source && item->evt.value == e.value)
+            {
+                item->evt = e;
+                return queueLength;
+            }
+        } while (item != evt_queue);
+    }
 
-        while (p->next != NULL)
+    if (queueLength >= queueCapacity)
+    {
+        if (!(flags & MESSAGE_BUS_LISTENER_DROP_OLDEST) || evt_queue == NULL)
         {
-            p = p->next;
-            queueDepth++;
+            microbit_trace(MICROBIT_TRACE_EVENT_DROPPED, e.source, e.value, MICROBIT_TRACE_DROP_LISTENER_FULL);
+            return queueLength;
         }
 
-        if (queueDepth < MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH) 
-            p->next = new MicroBitEventQueueItem(e);
+        // The oldest event follows the newest, so can simply be overwritten to become the newest.
+        evt_queue = evt_queue->next;
+        microbit_trace(MICROBIT_TRACE_EVENT_DROPPED, evt_queue->evt.source, evt_queue->evt.value, MICROBIT_TRACE_DROP_LISTENER_FULL);
+        evt_queue->evt = e;
+
+        return queueLength;
+    }
+
+    item = new MicroBitEventQueueItem(e);
+
+    if (item == NULL)
+        return queueLength;
+
+    if (evt_queue == NULL)
+        item->next = item;
+    else
+    {
+        item->next = evt_queue->next;
+        evt_queue->next = item;
     }
+
+    evt_queue = item;
+    queueLength++;
+
+    return queueLength;
+}
+
+/**
+  * Removes the oldest event from the queue.
+  * @param e The event to fill in with the oldest event.
+  * @return 1 if an event was dequeued, or 0 if the queue is empty.
+  */
+int MicroBitListener::dequeue(MicroBitEvent &e)
+{
+    if (evt_queue == NULL)
+        return 0;
+
+    MicroBitEventQueueItem *item = evt_queue->next;
+
+    e = item->evt;
+
+    if (item == evt_queue)
+        evt_queue = NULL;
+    else
+        evt_queue->next = item->next;
+
+    delete item;
+    queueLength--;
+
+    return 1;
+}
+
+/**
+  * Allocates memory for a MicroBitListener from listenerPool, or the heap should the pool be empty.
+  */
+void *MicroBitListener::operator new(size_t size)
+{
+    void *p = listenerPool.allocate();
+
+    return p ? p : microbit_malloc(size);
+}
+
+/**
+  * Releases the memory of a MicroBitListener back to wherever it was allocated from.
+  */
+void MicroBitListener::operator delete(void *ptr)
+{
+    if (!listenerPool.release(ptr))
+        microbit_free(ptr);
 }
@@ -6,6 +6,62 @@
 
 #include "MicroBit.h"
 
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+// Latency statistics of each event source, in the order they were first seen. The final entry counts the events
+// from any further sources.
+static MicroBitEventLatency latencyStatistics[MESSAGE_BUS_LATENCY_SOURCES + 1];
+
+// The deepest the event queue has been.
+static uint16_t maxQueueLength = 0;
+
+/**
+  * Records the latency of an event in the statistics of its source.
+  *
+  * @param source The source of the event.
+  * @param latency The latency to record (us).
+  * @param handled true if this is the time until a handler completed, false if it is the time spent queued.
+  */
+static void latency_record(uint16_t source, uint32_t latency, bool handled)
+{
+    MicroBitEventLatency *stats = &latencyStatistics[MESSAGE_BUS_LATENCY_SOURCES];
+    int bucket = 0;
+
+    while (bucket < MESSAGE_BUS_LATENCY_BUCKETS - 1 && latency >= ((uint32_t) MESSAGE_BUS_LATENCY_RESOLUTION_US << bucket))
+        bucket++;
+
+    // Events can be handled in interrupt context too (by urgent listeners), so hold interrupts off.
+    __disable_irq();
+
+    // Find this source, or the first unused entry for it.
+    for (int i = 0; i < MESSAGE_BUS_LATENCY_SOURCES; i++)
+    {
+        if (latencyStatistics[i].source == source || latencyStatistics[i].source == MICROBIT_ID_ANY)
+        {
+            stats = &latencyStatistics[i];
+            stats->source = source;
+            break;
+        }
+    }
+
+    if (handled)
+    {
+        stats->handled[bucket]++;
+
+        if (latency > stats->maxHandled)
+            stats->maxHandled = latency;
+    }
+    else
+    {
+        stats->queued[bucket]++;
+
+        if (latency > stats->maxQueued)
+            stats->maxQueued = latency;
+    }
+
+    __enable_irq();
+}
+#endif
+
 /**
   * Constructor.
   * Create a new Message Bus.
@@ -13,9 +69,60 @@
 MicroBitMessageBus::MicroBitMessageBus()
 {
 	this->listeners = NULL;
-    this->evt_queue_head = NULL;
-    this->evt_queue_tail = NULL;
+
+#if MESSAGE_BUS_LISTENER_BUCKETS > 0
+    for (int i = 0; i < MESSAGE_BUS_LISTENER_BUCKETS; i++)
+        this->listenerIndex[i] = NULL;
+#endif
+
+    this->queueHead = 0;
+    this->queueTail = 0;
     this->queueLength = 0;
+    this->droppedEvents = 0;
+    this->batchPending = false;
+
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    this->eventFibers = 0;
+    this->eventFiberQueue = NULL;
+#endif
+}
+
+/**
+  * Delivers the events gathered by a batched listener in one or more calls to its handler, until none remain.
+  * Events gathered while the handler runs are delivered in a further call.
+  *
+  * @param listener The batched listener.
+  */
+static void async_batch_callback(MicroBitListener *listener)
+{
+    MicroBitEvent batch[MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH];
+    int count;
+
+    do
+    {
+        count = 0;
+
+        while (count < MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH && listener->dequeue(batch[count]))
+            count++;
+
+        if (listener->flags & MESSAGE_BUS_LISTENER_METHOD)
+            listener->cb_method->fire(batch, count);
+        else
+            listener->cb_batch(batch, count);
+
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+        uint32_t now = us_ticker_read();
+
+        for (int i = 0; i < count; i++)
+            latency_record(batch[i].source, now - batch[i].latencyFrom, true);
+#endif
+
+        // We spin the scheduler here, to preven any particular event handler from continuously holding onto resources.
+        // Non-blocking listeners may be running in interrupt context, so must not.
+        if (listener->evt_queue && !(listener->flags & MESSAGE_BUS_LISTENER_NONBLOCKING))
+            schedule();
+
+    } while (listener->evt_queue);
 }
 
 /**
@@ -35,9 +142,16 @@ void async_callback(void *param)
 
     if (listener->flags & MESSAGE_BUS_LISTENER_BUSY)
     {
+        // A batched listener already holds this event in its queue, and the fiber in the listener will deliver it.
+        if (listener->flags & MESSAGE_BUS_LISTENER_BATCH)
+            return;
+
         // Drop this event, if that's how we've been configured.
         if (listener->flags & MESSAGE_BUS_LISTENER_DROP_IF_BUSY)
+        {
+            microbit_trace(MICROBIT_TRACE_EVENT_DROPPED, listener->evt.source, listener->evt.value, MICROBIT_TRACE_DROP_LISTENER_BUSY);
             return;
+        }
 
         // Queue this event up for later, if that's how we've been configured.
         if (listener->flags & MESSAGE_BUS_LISTENER_QUEUE_IF_BUSY)
@@ -53,8 +167,21 @@ void async_callback(void *param)
     // Record that we have a fiber going into this listener...
     listener->flags |= MESSAGE_BUS_LISTENER_BUSY;
 
+    if (listener->flags & MESSAGE_BUS_LISTENER_BATCH)
+    {
+        async_batch_callback(listener);
+        listener->flags &= ~MESSAGE_BUS_LISTENER_BUSY;
+        return;
+    }
+
     while (1)
     {
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+        // Take a copy, as a reentrant listener may be given another event while the handler runs.
+        uint16_t source = listener->evt.source;
+        uint32_t dispatchedAt = listener->evt.latencyFrom;
+#endif
+
         // Firstly, check for a method callback into an object.
         if (listener->flags & MESSAGE_BUS_LISTENER_METHOD)
             listener->cb_method->fire(listener->evt);
@@ -67,15 +194,13 @@ void async_callback(void *param)
         else
             listener->cb(listener->evt);
 
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+        latency_record(source, us_ticker_read() - dispatchedAt, true);
+#endif
+
         // If there are more events to process, dequeue the next one and process it.
-        if ((listener->flags & MESSAGE_BUS_LISTENER_QUEUE_IF_BUSY) && listener->evt_queue)
+        if ((listener->flags & MESSAGE_BUS_LISTENER_QUEUE_IF_BUSY) && listener->dequeue(listener->evt))
         {
-            MicroBitEventQueueItem *item = listener->evt_queue;
-
-            listener->evt = item->evt;
-            listener->evt_queue = listener->evt_queue->next;
-            delete item;
-
             // We spin the scheduler here, to preven any particular event handler from continuously holding onto resources.
             schedule();
         }
@@ -87,17 +212,44 @@ void async_callback(void *param)
     listener->flags &= ~MESSAGE_BUS_LISTENER_BUSY;
 }
 
+/**
+  * Calls the handler of the given listener, for the event (or batch of events) it has been given.
+  * @param listener The listener to dispatch.
+  */
+static void listener_dispatch(MicroBitListener *listener)
+{
+    // OK, if this handler has regisitered itself as non-blocking, we just execute it directly...
+    // This is normally only done for trusted system components.
+    // Otherwise, we invoke it in a 'fork on block' context, that will automatically create a fiber
+    // should the event handler attempt a blocking operation, but doesn't have the overhead
+    // of creating a fiber needlessly. (cool huh?)
+    if (listener->flags & MESSAGE_BUS_LISTENER_NONBLOCKING)
+        async_callback(listener);
+    else
+        invoke(async_callback, listener);
+}
+
 /**
   * Queue the given event for processing at a later time.
   * Add the given event at the tail of our queue.
   *
   * @param The event to queue.
+  * @param coalesce If set to true, the event replaces any event with the same source and value already in the queue.
   */
-void MicroBitMessageBus::queueEvent(MicroBitEvent &evt)
+void MicroBitMessageBus::queueEvent(MicroBitEvent &evt, bool coalesce)
 {
     int processingComplete;
 
-    MicroBitEventQueueItem *prev = evt_queue_tail;
+    microbit_trace(MICROBIT_TRACE_EVENT_FIRED, evt.source, evt.value, queueLength);
+
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    // Urgent listeners are dispatched right away, so this is both the time the event was queued and dispatched.
+    evt.latencyFrom = us_ticker_read();
+#endif
+
+    // Record the tail of the queue at the point where we entered queueEvent().
+    // A single halfword read is atomic, so we needn't disable interrupts for this.
+    uint16_t position = queueTail;
 
     // Now process all handler regsitered as URGENT.
     // These pre-empt the queue, and are useful for fast, high priority services.
@@ -108,65 +260,98 @@ void MicroBitMessageBus::queueEvent(MicroBitEvent &evt)
     if (processingComplete)
         return;
 
-    // If we need to queue, but there is no space, then there's nothg we can do.
-    if (queueLength >= MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH)
+    __disable_irq();
+
+    // If we're coalescing, an event already waiting in the queue can simply be brought up to date.
+    if (coalesce)
+    {
+        uint16_t i = queueHead;
+
+        for (int n = 0; n < queueLength; n++)
+        {
+            if (evt_queue[i].source == evt.source && evt_queue[i].value == evt.value)
+            {
+                evt_queue[i] = evt;
+                __enable_irq();
+                return;
+            }
+
+            i = i + 1 == MESSAGE_BUS_EVENT_QUEUE_DEPTH ? 0 : i + 1;
+        }
+    }
+
+    // If we need to queue, but there is no space, then there's nothing we can do but keep count.
+    if (queueLength >= MESSAGE_BUS_EVENT_QUEUE_DEPTH)
+    {
+        droppedEvents++;
+        __enable_irq();
+
+        microbit_trace(MICROBIT_TRACE_EVENT_DROPPED, evt.source, evt.value, MICROBIT_TRACE_DROP_QUEUE_FULL);
         return;
+    }
 
     // Otherwise, we need to queue this event for later processing...
     // We queue this event at the tail of the queue at the point where we entered queueEvent()
     // This is important as the processing above *may* have generated further events, and
-    // we want to maintain ordering of events.
-    MicroBitEventQueueItem *item = new MicroBitEventQueueItem(evt);
+    // we want to maintain ordering of events. Any such events are moved back one place to make room.
+    // The events ahead of that point (or the point itself) may have been consumed in the meantime, in which case
+    // it no longer lies between the head and tail of the queue, and we simply queue at the tail. This also bounds
+    // the work done here to moving the events raised by urgent listeners.
+    if ((position + MESSAGE_BUS_EVENT_QUEUE_DEPTH - queueHead) % MESSAGE_BUS_EVENT_QUEUE_DEPTH > queueLength)
+        position = queueTail;
 
-    // The queue was empty when we entered this function, so queue our event at the start of the queue.
-    __disable_irq();
+    uint16_t i = queueTail;
 
-    if (prev == NULL)
+    while (i != position)
     {
-        item->next = evt_queue_head;
-        evt_queue_head = item;
-    }
-    else
-    {
-        item->next = prev->next;
-        prev->next = item;
+        uint16_t previous = (i == 0 ? MESSAGE_BUS_EVENT_QUEUE_DEPTH : i) - 1;
+        evt_queue[i] = evt_queue[previous];
+        i = previous;
     }
 
-    if (item->next == NULL)
-        evt_queue_tail = item;
+    evt_queue[position] = evt;
+
+    queueTail = queueTail + 1 == MESSAGE_BUS_EVENT_QUEUE_DEPTH ? 0 : queueTail + 1;
+    queueLength = queueLength + 1;
 
-    queueLength++;
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    if (queueLength > maxQueueLength)
+        maxQueueLength = queueLength;
+#endif
 
     __enable_irq();
+
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    // Wake an event fiber to deliver the event, if none is already awake.
+    fiber_wake_one(&eventFiberQueue);
+#endif
 }
 
 /**
   * Extract the next event from the front of the event queue (if present).
-  * @return
   *
-  * @param The event to queue.
+  * @param evt The event to fill in with the next event.
+  * @return 1 if an event was dequeued, or 0 if the queue is empty.
   */
-MicroBitEventQueueItem* MicroBitMessageBus::dequeueEvent()
+int MicroBitMessageBus::dequeueEvent(MicroBitEvent &evt)
 {
-    MicroBitEventQueueItem *item = NULL;
+    int dequeued = 0;
 
     __disable_irq();
 
-    if (evt_queue_head != NULL)
+    if (queueLength > 0)
     {
-        item = evt_queue_head;
-        evt_queue_head = item->next;
+        evt = evt_queue[queueHead];
 
-        if (evt_queue_head == NULL)
-            evt_queue_tail = NULL;
+        queueHead = queueHead + 1 == MESSAGE_BUS_EVENT_QUEUE_DEPTH ? 0 : queueHead + 1;
+        queueLength = queueLength - 1;
 
-        queueLength--;
+        dequeued = 1;
     }
 
     __enable_irq();
 
-
-    return item;
+    return dequeued;
 }
 
 /**
@@ -176,33 +361,37 @@ MicroBitEventQueueItem* MicroBitMessageBus::dequeueEvent()
 int MicroBitMessageBus::deleteMarkedListeners()
 {
 	MicroBitListener *l, *p;
+    MicroBitListener **chain;
     int removed = 0;
 
-	l = listeners;
-	p = NULL;
-
-    // Walk this list of event handlers. Delete any that match the given listener.
-    while (l != NULL)
+    for (int i = 0; (chain = listenerChainAt(i)) != NULL; i++)
     {
-        if (l->flags & MESSAGE_BUS_LISTENER_DELETING && !l->flags & MESSAGE_BUS_LISTENER_BUSY)
+        l = *chain;
+        p = NULL;
+
+        // Walk this list of event handlers. Delete any that match the given listener.
+        while (l != NULL)
         {
-            if (p == NULL)
-                listeners = l->next;
-            else
-                p->next = l->next;
+            if (l->flags & MESSAGE_BUS_LISTENER_DELETING && !l->flags & MESSAGE_BUS_LISTENER_BUSY)
+            {
+                if (p == NULL)
+                    *chain = l->next;
+                else
+                    p->next = l->next;
 
-            // delete the listener.
-            MicroBitListener *t = l;
-            l = l->next;
+                // delete the listener.
+                MicroBitListener *t = l;
+                l = l->next;
 
-            delete t;
-            removed++;
+                delete t;
+                removed++;
 
-            continue;
-        }
+                continue;
+            }
 
-        p = l;
-        l = l->next;
+            p = l;
+            l = l->next;
+        }
     }
 
     return removed;
@@ -218,25 +407,120 @@ void MicroBitMessageBus::idleTick()
     // Clear out any listeners marked for deletion
     this->deleteMarkedListeners();
 
-    MicroBitEventQueueItem *item = this->dequeueEvent();
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    // Events are delivered by the event fibers, if they are running.
+    if (eventFibers > 0)
+        return;
+#endif
+
+    this->processQueue(true);
+}
+
+/**
+  * Delivers the events in the queue to all standard listeners, then any batches gathered.
+  *
+  * @param yield If set to true, stops once there are fibers on the run queue, leaving any further events queued.
+  */
+void MicroBitMessageBus::processQueue(bool yield)
+{
+    MicroBitEvent evt;
 
     // Whilst there are events to process and we have no useful other work to do, pull them off the queue and process them.
-    while (item)
+    while (this->dequeueEvent(evt))
     {
-        // send the event to all standard event listeners.
-        this->process(item->evt);
+        microbit_trace(MICROBIT_TRACE_EVENT_DISPATCHED, evt.source, evt.value, queueLength);
 
-        // Free the queue item.
-        delete item;
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+        uint32_t now = us_ticker_read();
+
+        latency_record(evt.source, now - evt.latencyFrom, false);
+        evt.latencyFrom = now;
+#endif
+
+        // send the event to all standard event listeners.
+        this->process(evt);
 
         // If we have created some useful work to do, we stop processing.
         // This helps to minimise the number of blocked fibers we create at any point in time, therefore
         // also reducing the RAM footprint.
-        if(!scheduler_runqueue_empty())
+        if(yield && !scheduler_runqueue_empty())
             break;
+    }
+
+    // Once the event queue is empty, batched listeners are given everything they have gathered.
+    if (batchPending && queueLength == 0)
+        this->dispatchBatches();
+}
+
+/**
+  * Entry point of the event fibers. Delivers events until the queue is empty, then sleeps until another is queued.
+  *
+  * @param param The message bus.
+  */
+void MicroBitMessageBus::eventFiber(void *param)
+{
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    MicroBitMessageBus *bus = (MicroBitMessageBus *)param;
+
+    while (1)
+    {
+        bus->processQueue(false);
+
+        // Wait on our own queue, which only queueEvent() wakes. We join it before checking for more work, so that
+        // an event queued from here on is certain to wake one of us.
+        dequeue_fiber(currentFiber);
+        queue_fiber(currentFiber, &bus->eventFiberQueue);
+
+        if (bus->queueLength > 0 || bus->batchPending)
+            fiber_wake_one(&bus->eventFiberQueue);
+
+        schedule();
+    }
+#endif
+}
+
+/**
+  * Starts the fibers that deliver queued events to standard listeners (see MESSAGE_BUS_EVENT_FIBERS), in place of
+  * the idle task.
+  *
+  * @return MICROBIT_OK, MICROBIT_NO_RESOURCES if no fibers could be created, or MICROBIT_NOT_SUPPORTED if
+  * MESSAGE_BUS_EVENT_FIBERS is 0.
+  */
+int MicroBitMessageBus::startEventFibers()
+{
+#if MESSAGE_BUS_EVENT_FIBERS > 0
+    while (eventFibers < MESSAGE_BUS_EVENT_FIBERS)
+    {
+        if (create_fiber(eventFiber, this, release_fiber, MICROBIT_FIBER_FLAG_PRIORITY(MESSAGE_BUS_EVENT_FIBER_PRIORITY)) == NULL)
+            break;
+
+        eventFibers++;
+    }
+
+    return eventFibers > 0 ? MICROBIT_OK : MICROBIT_NO_RESOURCES;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Delivers the events gathered by every batched listener that is not already busy handling a batch.
+  * Those that are busy deliver their gathered events themselves, once the handler returns.
+  */
+void MicroBitMessageBus::dispatchBatches()
+{
+	MicroBitListener *l;
+    MicroBitListener **chain;
 
-        // Pull the next event to process, if there is one.
-        item = this->dequeueEvent();
+    batchPending = false;
+
+    for (int i = 0; (chain = listenerChainAt(i)) != NULL; i++)
+    {
+        for (l = *chain; l != NULL; l = l->next)
+        {
+            if ((l->flags & MESSAGE_BUS_LISTENER_BATCH) && l->evt_queue && !(l->flags & (MESSAGE_BUS_LISTENER_BUSY | MESSAGE_BUS_LISTENER_DELETING)))
+                listener_dispatch(l);
+        }
     }
 }
 
@@ -246,7 +530,16 @@ void MicroBitMessageBus::idleTick()
   */
 int MicroBitMessageBus::isIdleCallbackNeeded()
 {
-    return !(evt_queue_head == NULL);
+    return queueLength > 0 || batchPending;
+}
+
+/**
+  * Events are queued by interrupt handlers, which wake the processor anyway, so no system ticks are needed
+  * for the queue to be processed.
+  */
+unsigned long MicroBitMessageBus::systemTickPeriod()
+{
+    return MICROBIT_TICK_PERIOD_UNLIMITED;
 }
 
 /**
@@ -273,6 +566,25 @@ void MicroBitMessageBus::send(MicroBitEvent evt)
     this->queueEvent(evt);
 }
 
+/**
+  * Queues the given event to be sent to all registered recipients, in place of any event with the same
+  * source and value still waiting to be processed. Urgent listeners still receive every event.
+  *
+  * Use this for events that signal a new sample is available, so that if handlers fall behind they are
+  * given only the latest, and the queue does not fill with stale events.
+  *
+  * @param The event to send.
+  *
+  * Example:
+  * @code
+  * MicroBitEvent evt(MICROBIT_ID_ACCELEROMETER, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, CREATE_AND_COALESCE);
+  * @endcode
+  */
+void MicroBitMessageBus::coalesce(MicroBitEvent evt)
+{
+    this->queueEvent(evt, true);
+}
+
 /*
  * Deliver the given event to all registered event handlers.
  * Event handlers are called using the invoke() mechanism provided by the fier scheduler
@@ -280,7 +592,7 @@ void MicroBitMessageBus::send(MicroBitEvent evt)
  * event handler attempt a blocking operation.
  * @param evt The event to be delivered.
  * @param urgent The type of listeners to process (optional). If set to true, only listeners defined as urgent and non-blocking will be processed
- * otherwise, all other (standard) listeners will be processed.
+ * (the static listeners of system components first), otherwise, all other (standard) listeners will be processed.
  * @return 1 if all matching listeners were processed, 0 if further processing is required.
  */
 int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
@@ -289,34 +601,49 @@ int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
     int complete = 1;
     bool listenerUrgent;
 
-    l = listeners;
-    while (l != NULL)
+    // Only two chains can hold listeners to this event: those listening to any source, and those listening to this one.
+    // If there is no index, both are the same chain.
+    MicroBitListener **chains[2] = { &listeners, listenerChain(evt.source) };
+
+    // Listeners fixed at compile time come first. They are all urgent.
+    if (urgent)
+    {
+        for (const MicroBitStaticListener *s = microbit_static_listeners; s < microbit_static_listeners + microbit_static_listener_count; s++)
+            if ((s->id == evt.source || s->id == MICROBIT_ID_ANY) && (s->value == evt.value || s->value == MICROBIT_EVT_ANY))
+                s->handler(evt);
+    }
+
+    for (int i = 0; i < (chains[1] == &listeners ? 1 : 2); i++)
     {
-	    if((l->id == evt.source || l->id == MICROBIT_ID_ANY) && (l->value == evt.value || l->value == MICROBIT_EVT_ANY))
+        l = *chains[i];
+        while (l != NULL)
         {
-            listenerUrgent = (l->flags & MESSAGE_BUS_LISTENER_IMMEDIATE) == MESSAGE_BUS_LISTENER_IMMEDIATE;
-            if(listenerUrgent == urgent && !(l->flags & MESSAGE_BUS_LISTENER_DELETING))
+            // Every listener holds a range of IDs and values, with wildcards as the widest possible range.
+            // Only a filtered listener to a set of values needs further checks.
+            if(evt.source >= l->id && evt.source <= l->idTo && evt.value >= l->value && evt.value <= l->valueTo &&
+                (!(l->flags & MESSAGE_BUS_LISTENER_VALUE_MASK) || (l->valueMask & MICROBIT_EVT_MASK(evt.value))))
             {
-                l->evt = evt;
-
-                // OK, if this handler has regisitered itself as non-blocking, we just execute it directly...
-                // This is normally only done for trusted system components.
-                // Otherwise, we invoke it in a 'fork on block' context, that will automatically create a fiber
-                // should the event handler attempt a blocking operation, but doesn't have the overhead
-                // of creating a fiber needlessly. (cool huh?)
-                if (l->flags & MESSAGE_BUS_LISTENER_NONBLOCKING)
-                    async_callback(l);
+                listenerUrgent = (l->flags & MESSAGE_BUS_LISTENER_IMMEDIATE) == MESSAGE_BUS_LISTENER_IMMEDIATE;
+                if(listenerUrgent == urgent && !(l->flags & MESSAGE_BUS_LISTENER_DELETING))
+                {
+                    l->evt = evt;
+
+                    // A batched listener gathers events until the event queue has been drained (see idleTick()), unless
+                    // it is urgent, or its batch is full.
+                    if (!(l->flags & MESSAGE_BUS_LISTENER_BATCH) || l->queue(evt) >= l->queueCapacity || urgent)
+                        listener_dispatch(l);
+                    else
+                        batchPending = true;
+                }
                 else
-                    invoke(async_callback, l);
-            }
-            else
-            {
-                complete = 0;
+                {
+                    complete = 0;
+                }
             }
-		}
 
-		l = l->next;
-	}
+            l = l->next;
+        }
+    }
 
     return complete;
 }
@@ -344,7 +671,7 @@ int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
   * @endcode
   */
 
-int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags)
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent), uint32_t flags)
 {
 	if (handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
@@ -360,7 +687,7 @@ int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent)
 
 }
 
-int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags)
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint32_t flags)
 {
 	if (handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
@@ -375,6 +702,103 @@ int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent,
     return MICROBIT_NO_RESOURCES;
 }
 
+/**
+  * Register a batched listener function (see MicroBitMessageBus.h).
+  *
+  * @param id The source of messages to listen for. Use MICROBIT_ID_ANY to receive events from all components.
+  * @param value The value of messages to listen for. Use MICROBIT_EVT_ANY to receive events of any value.
+  * @param handler The function to call with the events received, and their number.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent*, int), uint32_t flags)
+{
+	if (handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(id, value, handler, flags);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+  * Register a listener function, for the events described by the given filter.
+  *
+  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+  * @param handler The function to call when an event is received.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+int MicroBitMessageBus::listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent), uint32_t flags)
+{
+	if (handler == NULL || checkFilter(filter) != MICROBIT_OK)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(filter.id, filter.value, handler, flags);
+    newListener->setFilter(filter);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+  * Register a parameterised listener function, for the events described by the given filter.
+  *
+  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+  * @param handler The function to call when an event is received.
+  * @param arg An additional argument to pass to the handler.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+int MicroBitMessageBus::listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent, void*), void* arg, uint32_t flags)
+{
+	if (handler == NULL || checkFilter(filter) != MICROBIT_OK)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(filter.id, filter.value, handler, arg, flags);
+    newListener->setFilter(filter);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+  * Register a batched listener function, for the events described by the given filter.
+  *
+  * @param filter The source IDs and values of messages to listen for. All other events will be filtered.
+  * @param handler The function to call with the events received, and their number.
+  *
+  * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+  */
+int MicroBitMessageBus::listen(const MicroBitEventFilter &filter, void (*handler)(MicroBitEvent*, int), uint32_t flags)
+{
+	if (handler == NULL || checkFilter(filter) != MICROBIT_OK)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(filter.id, filter.value, handler, flags);
+    newListener->setFilter(filter);
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+
+    return MICROBIT_NO_RESOURCES;
+}
+
 /**
  * Unregister a listener function.
  * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
@@ -436,6 +860,54 @@ int MicroBitMessageBus::ignore(int id, int value, void (*handler)(MicroBitEvent,
     return MICROBIT_OK;
 }
 
+/**
+ * Unregister a batched listener function.
+ * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+ *
+ * @param id The Event ID used to register the listener.
+ * @param value The Event VALUE used to register the listener.
+ * @param handler The function used to register the listener.
+ */
+int MicroBitMessageBus::ignore(int id, int value, void (*handler)(MicroBitEvent*, int))
+{
+	if (handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener listener(id, value, handler);
+    remove(&listener);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Determines if two listeners have the same filter (if any), in addition to the same ID and value.
+  */
+static int listener_same_filter(MicroBitListener *a, MicroBitListener *b)
+{
+    if ((a->flags ^ b->flags) & (MESSAGE_BUS_LISTENER_FILTERED | MESSAGE_BUS_LISTENER_VALUE_MASK))
+        return 0;
+
+    if (!(a->flags & MESSAGE_BUS_LISTENER_FILTERED))
+        return 1;
+
+    return a->idTo == b->idTo && a->valueTo == b->valueTo && (!(a->flags & MESSAGE_BUS_LISTENER_VALUE_MASK) || a->valueMask == b->valueMask);
+}
+
+/**
+  * Checks that the given filter describes at least one event.
+  * @param filter The filter to check.
+  * @return MICROBIT_OK if the filter is valid, MICROBIT_INVALID_PARAMETER otherwise.
+  */
+int MicroBitMessageBus::checkFilter(const MicroBitEventFilter &filter)
+{
+    if (filter.id != MICROBIT_ID_ANY && filter.idTo < filter.id)
+        return MICROBIT_INVALID_PARAMETER;
+
+    if (filter.valueMask == 0 && filter.value != MICROBIT_EVT_ANY && filter.valueTo < filter.value)
+        return MICROBIT_INVALID_PARAMETER;
+
+    return MICROBIT_OK;
+}
 
 /**
   * Add the given MicroBitListener to the list of event handlers, unconditionally.
@@ -451,7 +923,18 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	if (newListener == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
-	l = listeners;
+    // Unfiltered listeners are given the range of their ID and value, so that all listeners are matched alike.
+    if (!(newListener->flags & MESSAGE_BUS_LISTENER_FILTERED))
+    {
+        newListener->idTo = newListener->id == MICROBIT_ID_ANY ? 0xFFFF : newListener->id;
+        newListener->valueTo = newListener->value == MICROBIT_EVT_ANY ? 0xFFFF : newListener->value;
+    }
+
+    // Any existing listener for the same ID is on the same chain.
+    // A listener to a range of IDs could match events on any chain, so is held with those listening to MICROBIT_ID_ANY.
+    MicroBitListener **chain = listenerChain(newListener->idTo != newListener->id ? MICROBIT_ID_ANY : newListener->id);
+
+	l = *chain;
 
 	// Firstly, we treat a listener as an idempotent operation. Ensure we don't already have this handler
 	// registered in a that will already capture these events. If we do, silently ignore.
@@ -462,7 +945,7 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
     {
         methodCallback = (newListener->flags & MESSAGE_BUS_LISTENER_METHOD) && (l->flags & MESSAGE_BUS_LISTENER_METHOD);
 
-        if (l->id == newListener->id && l->value == newListener->value && (methodCallback ? *l->cb_method == *newListener->cb_method : l->cb == newListener->cb))
+        if (l->id == newListener->id && l->value == newListener->value && listener_same_filter(l, newListener) && (methodCallback ? *l->cb_method == *newListener->cb_method : l->cb == newListener->cb))
         {
             // We have a perfect match for this event listener already registered.
             // If it's marked for deletion, we simply resurrect the listener, and we're done.
@@ -477,10 +960,10 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
     }
 
     // We have a valid, new event handler. Add it to the list.
-	// if listeners is null - we can automatically add this listener to the list at the beginning...
-	if (listeners == NULL)
+	// if the chain is empty - we can automatically add this listener to the list at the beginning...
+	if (*chain == NULL)
 	{
-		listeners = newListener;
+		*chain = newListener;
 		return MICROBIT_OK;
 	}
 
@@ -489,8 +972,8 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	// Find the correct point in the chain for this event.
 	// Adding a listener is a rare occurance, so we just walk the list...
 
-	p = listeners;
-	l = listeners;
+	p = *chain;
+	l = *chain;
 
 	while (l != NULL && l->id < newListener->id)
 	{
@@ -505,12 +988,12 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	}
 
 	//add at front of list
-	if (p == listeners && (newListener->id < p->id || (p->id == newListener->id && p->value > newListener->value)))
+	if (p == *chain && (newListener->id < p->id || (p->id == newListener->id && p->value > newListener->value)))
 	{
 		newListener->next = p;
 
 		//this new listener is now the front!
-		listeners = newListener;
+		*chain = newListener;
 	}
 
 	//add after p
@@ -531,32 +1014,41 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 int MicroBitMessageBus::remove(MicroBitListener *listener)
 {
 	MicroBitListener *l;
+    MicroBitListener **chain;
     int removed = 0;
 
 	//handler can't be NULL!
 	if (listener == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
-	l = listeners;
-
-    // Walk this list of event handlers. Delete any that match the given listener.
-    while (l != NULL)
+    // A listener to a given ID can only be on its own chain, or with those to MICROBIT_ID_ANY should it listen to a
+    // range of IDs. MICROBIT_ID_ANY matches listeners on every chain.
+    for (int i = 0; (chain = listenerChainAt(i)) != NULL; i++)
     {
-        if ((listener->flags & MESSAGE_BUS_LISTENER_METHOD) == (l->flags & MESSAGE_BUS_LISTENER_METHOD))
+        if (listener->id != MICROBIT_ID_ANY && chain != listenerChain(listener->id) && chain != &listeners)
+            continue;
+
+        l = *chain;
+
+        // Walk this list of event handlers. Delete any that match the given listener.
+        while (l != NULL)
         {
-            if(((listener->flags & MESSAGE_BUS_LISTENER_METHOD) && (*l->cb_method == *listener->cb_method)) ||
-              ((!(listener->flags & MESSAGE_BUS_LISTENER_METHOD) && l->cb == listener->cb)))
+            if ((listener->flags & MESSAGE_BUS_LISTENER_METHOD) == (l->flags & MESSAGE_BUS_LISTENER_METHOD))
             {
-                if ((listener->id == MICROBIT_ID_ANY || listener->id == l->id) && (listener->value == MICROBIT_EVT_ANY || listener->value == l->value))
+                if(((listener->flags & MESSAGE_BUS_LISTENER_METHOD) && (*l->cb_method == *listener->cb_method)) ||
+                  ((!(listener->flags & MESSAGE_BUS_LISTENER_METHOD) && l->cb == listener->cb)))
                 {
-                    // Found a match. mark this to be removed from the list.
-                    l->flags |= MESSAGE_BUS_LISTENER_DELETING;
-                    removed++;
+                    if ((listener->id == MICROBIT_ID_ANY || listener->id == l->id) && (listener->value == MICROBIT_EVT_ANY || listener->value == l->value))
+                    {
+                        // Found a match. mark this to be removed from the list.
+                        l->flags |= MESSAGE_BUS_LISTENER_DELETING;
+                        removed++;
+                    }
                 }
             }
-        }
 
-        l = l->next;
+            l = l->next;
+        }
     }
 
     if (removed > 0)
@@ -565,6 +1057,39 @@ int MicroBitMessageBus::remove(MicroBitListener *listener)
         return MICROBIT_INVALID_PARAMETER;
 }
 
+/**
+ * Determines the chain of listeners that holds those listening to the given source ID.
+ * @param id The source ID.
+ * @return The head of the chain.
+ */
+MicroBitListener **MicroBitMessageBus::listenerChain(uint16_t id)
+{
+#if MESSAGE_BUS_LISTENER_BUCKETS > 0
+    if (id != MICROBIT_ID_ANY)
+        return &listenerIndex[id & (MESSAGE_BUS_LISTENER_BUCKETS - 1)];
+#endif
+
+    return &listeners;
+}
+
+/**
+ * Returns the nth chain of listeners, in order to visit every listener.
+ * @param n The position of the chain.
+ * @return The head of the chain, or NULL if the position is invalid.
+ */
+MicroBitListener **MicroBitMessageBus::listenerChainAt(int n)
+{
+    if (n == 0)
+        return &listeners;
+
+#if MESSAGE_BUS_LISTENER_BUCKETS > 0
+    if (n <= MESSAGE_BUS_LISTENER_BUCKETS)
+        return &listenerIndex[n - 1];
+#endif
+
+    return NULL;
+}
+
 /**
  * Returns the microBitListener with the given position in our list.
  * @param n The position in the list to return.
@@ -572,18 +1097,149 @@ int MicroBitMessageBus::remove(MicroBitListener *listener)
  */
 MicroBitListener* MicroBitMessageBus::elementAt(int n)
 {
-    MicroBitListener *l = listeners;
+    MicroBitListener **chain;
 
-    while (n > 0)
+    for (int i = 0; (chain = listenerChainAt(i)) != NULL; i++)
     {
-        if (l == NULL)
-            return NULL;
+        MicroBitListener *l = *chain;
 
-        n--;
-        l = l->next;
+        while (l != NULL)
+        {
+            if (n == 0)
+                return l;
+
+            n--;
+            l = l->next;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+  * Returns the number of events dropped since power on, because the event queue was full.
+  * @return The number of events dropped.
+  */
+uint32_t MicroBitMessageBus::getDroppedEventCount()
+{
+    return droppedEvents;
+}
+
+/**
+  * Reads the latency statistics recorded for events from one source. Sources are tracked in the order they
+  * are first seen, at positions 0 to MESSAGE_BUS_LATENCY_SOURCES - 1, and the events from any further sources
+  * are counted at position MESSAGE_BUS_LATENCY_SOURCES.
+  * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+  *
+  * @param n The position of the source, from 0.
+  * @param stats The structure to populate.
+  * @return MICROBIT_OK, MICROBIT_INVALID_PARAMETER if there is no such source or stats is NULL, or MICROBIT_NOT_SUPPORTED.
+  */
+int MicroBitMessageBus::getLatencyStatistics(int n, MicroBitEventLatency *stats)
+{
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    if (n < 0 || n > MESSAGE_BUS_LATENCY_SOURCES || stats == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    // Entries are used in order, so an unused entry marks the end of the sources tracked individually.
+    if (n < MESSAGE_BUS_LATENCY_SOURCES && latencyStatistics[n].source == MICROBIT_ID_ANY)
+        return MICROBIT_INVALID_PARAMETER;
+
+    __disable_irq();
+    *stats = latencyStatistics[n];
+    __enable_irq();
+
+    stats->source = n == MESSAGE_BUS_LATENCY_SOURCES ? MICROBIT_ID_ANY : stats->source;
+
+    return MICROBIT_OK;
+#else
+    (void)n;
+    (void)stats;
+
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Returns the greatest number of events that have been waiting in the event queue at once.
+  * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+  *
+  * @return The deepest the event queue has been, or MICROBIT_NOT_SUPPORTED.
+  */
+int MicroBitMessageBus::getMaxQueueDepth()
+{
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    return maxQueueLength;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Clears all latency statistics, and the deepest the event queue has been.
+  * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int MicroBitMessageBus::resetLatencyStatistics()
+{
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    __disable_irq();
+
+    memset(latencyStatistics, 0, sizeof(latencyStatistics));
+    maxQueueLength = queueLength;
+
+    __enable_irq();
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Writes the latency statistics of every source to the serial port, as two lines per source: one for the
+  * time events spent queued ('q') and one for the time until handlers completed ('h').
+  * Requires MESSAGE_BUS_LATENCY_STATISTICS to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int MicroBitMessageBus::printLatencyStatistics()
+{
+#if CONFIG_ENABLED(MESSAGE_BUS_LATENCY_STATISTICS)
+    MicroBitEventLatency stats;
+
+    uBit.serial.printf("max queue depth %d, dropped %d\n", maxQueueLength, droppedEvents);
+    uBit.serial.printf("source   max_us     <us:");
+
+    for (int i = 0; i < MESSAGE_BUS_LATENCY_BUCKETS - 1; i++)
+        uBit.serial.printf(" %-7d", MESSAGE_BUS_LATENCY_RESOLUTION_US << i);
+
+    uBit.serial.printf(" more\n");
+
+    for (int n = 0; n <= MESSAGE_BUS_LATENCY_SOURCES; n++)
+    {
+        // Skip over any unused entries.
+        if (getLatencyStatistics(n, &stats) != MICROBIT_OK)
+            continue;
+
+        uBit.serial.printf("%-5d q  %-10u     ", stats.source, stats.maxQueued);
+
+        for (int i = 0; i < MESSAGE_BUS_LATENCY_BUCKETS; i++)
+            uBit.serial.printf(" %-7u", stats.queued[i]);
+
+        uBit.serial.printf("\n%-5d h  %-10u     ", stats.source, stats.maxHandled);
+
+        for (int i = 0; i < MESSAGE_BUS_LATENCY_BUCKETS; i++)
+            uBit.serial.printf(" %-7u", stats.handled[i]);
+
+        uBit.serial.printf("\n");
     }
 
-    return l;
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
 }
 
 /**
@@ -1,5 +1,9 @@
 #include "MicroBit.h"
 
+/**
+  * Event handler for the events of buttons A and B, that forwards them to uBit.buttonAB.
+  * Called through the static listener table of the device (see microbit_static_listeners).
+  */
 void
 onMultiButtonEvent(MicroBitEvent evt)
 {   
@@ -35,8 +39,12 @@ MicroBitMultiButton::MicroBitMultiButton(uint16_t id, uint16_t button1, uint16_t
     this->button1 = button1;
     this->button2 = button2;
     
-    uBit.MessageBus.listen(button1, MICROBIT_EVT_ANY, onMultiButtonEvent,  MESSAGE_BUS_LISTENER_IMMEDIATE);
-    uBit.MessageBus.listen(button2, MICROBIT_EVT_ANY, onMultiButtonEvent,  MESSAGE_BUS_LISTENER_IMMEDIATE);
+    // uBit.buttonAB receives the events of its buttons through the static listener table of the device.
+    if (this != &uBit.buttonAB)
+    {
+        uBit.MessageBus.listen(button1, MICROBIT_EVT_ANY, this, &MicroBitMultiButton::onEvent, MESSAGE_BUS_LISTENER_IMMEDIATE);
+        uBit.MessageBus.listen(button2, MICROBIT_EVT_ANY, this, &MicroBitMultiButton::onEvent, MESSAGE_BUS_LISTENER_IMMEDIATE);
+    }
 }
 
 uint16_t MicroBitMultiButton::otherSubButton(uint16_t b)
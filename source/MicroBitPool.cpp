@@ -0,0 +1,65 @@
+/**
+  * A fixed size pool of objects of a single type, held in static storage.
+  */
+
+#include "MicroBit.h"
+
+/**
+  * Allocates an object from the pool.
+  * @return A pointer to memory for the object, or NULL if the pool is empty.
+  */
+void *MicroBitPool::allocate()
+{
+    void *object = NULL;
+
+    __disable_irq();
+
+    // Recycle a released object if we can. Otherwise, hand out the next object from the storage.
+    if (freeList != NULL)
+    {
+        object = freeList;
+        freeList = *(void **) object;
+    }
+    else if (issued < capacity)
+    {
+        object = (uint8_t *) storage + issued * objectSize;
+        issued++;
+    }
+
+    if (object != NULL)
+    {
+        inUse++;
+
+        if (inUse > maxInUse)
+            maxInUse = inUse;
+    }
+    else
+    {
+        misses++;
+    }
+
+    __enable_irq();
+
+    return object;
+}
+
+/**
+  * Returns an object to the pool, if it was allocated from it.
+  * @param object The object to release.
+  * @return 1 if the object was released into the pool, or 0 if it is not part of the pool.
+  */
+int MicroBitPool::release(void *object)
+{
+    if ((uint8_t *) object < (uint8_t *) storage || (uint8_t *) object >= (uint8_t *) storage + capacity * objectSize)
+        return 0;
+
+    __disable_irq();
+
+    *(void **) object = freeList;
+    freeList = object;
+    inUse--;
+
+    __enable_irq();
+
+    return 1;
+}
@@ -0,0 +1,162 @@
+/**
+  * The system tick of the MicroBit device class: starting, reconfiguring, and (with MICROBIT_TICKLESS_IDLE)
+  * suspending the periodic system tick. Shared by the device and host builds, which both compile this file.
+  */
+
+#include "MicroBit.h"
+
+/**
+  * Starts the periodic system tick.
+  * @param lag How far the system time lags behind real time, in microseconds.
+  */
+void MicroBit::startSystemTick(uint32_t lag)
+{
+    tickLag = lag;
+    tickStartedAt = us_ticker_read();
+
+    systemTicker.attach_us(this, &MicroBit::systemTick, tickPeriod * 1000);
+}
+
+/**
+  * Determines how far the system time currently lags behind real time (as it is only updated once per tick).
+  * @return The lag, in microseconds.
+  */
+uint32_t MicroBit::systemTickLag()
+{
+    // The system tick may not have been started yet.
+    if (tickPeriod == 0)
+        return 0;
+
+    return tickLag + (us_ticker_read() - tickStartedAt) % (tickPeriod * 1000);
+}
+
+/**
+  * Suspends the periodic system tick while the processor is idle, if nothing needs it for a while (tickless idle).
+  * A single system tick is instead scheduled for when a sleeping fiber is next due to be woken up, or a component
+  * next needs a tick (see MicroBitComponent::systemTickPeriod()), whichever is sooner.
+  * Called by the idle task just before the processor sleeps, and followed by resumeSystemTick() when it wakes.
+  *
+  * @return MICROBIT_OK if the system tick was suspended, or MICROBIT_BUSY if a tick is needed within the next two tick periods anyway.
+  */
+int MicroBit::suspendSystemTick()
+{
+    unsigned long period = scheduler_next_wakeup();
+    unsigned long p;
+
+    if (period > MICROBIT_TICKLESS_MAX_PERIOD_MS)
+        period = MICROBIT_TICKLESS_MAX_PERIOD_MS;
+
+    for(int i = 0; i < MICROBIT_SYSTEM_COMPONENTS; i++)
+        if(systemTickComponents[i] != NULL && (p = systemTickComponents[i]->systemTickPeriod()) < period)
+            period = p;
+
+    for(int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if(idleThreadComponents[i] != NULL && (p = idleThreadComponents[i]->systemTickPeriod()) < period)
+            period = p;
+
+    // Suspend for whole tick periods, so that fibers still wake up at exactly the same system time.
+    period -= period % tickPeriod;
+
+    if (period <= (unsigned long)tickPeriod || flags & MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED)
+        return MICROBIT_BUSY;
+
+    __disable_irq();
+
+    // An interrupt may have made a fiber runnable in the meantime, in which case we won't be sleeping at all.
+    if (!scheduler_runqueue_empty())
+    {
+        __enable_irq();
+        return MICROBIT_BUSY;
+    }
+
+    // Schedule the tick on a tick period boundary, just as the periodic tick would be.
+    uint32_t lag = systemTickLag();
+
+    tickSuspendedAt = us_ticker_read() - lag;
+    flags |= MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED;
+
+    systemTicker.attach_us(this, &MicroBit::systemTick, period * 1000 - lag);
+
+    __enable_irq();
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Ends a suspension of the system tick, from the single tick scheduled in its place.
+  * Advances the system time by the tick periods that have elapsed since the tick was suspended
+  * (less the current one, which scheduler_tick() accounts for), and restarts the periodic system tick.
+  */
+void MicroBit::restartSystemTick()
+{
+    uint32_t periodUs = tickPeriod * 1000;
+    uint32_t elapsed = us_ticker_read() - tickSuspendedAt;
+
+    // This tick was scheduled on a tick period boundary, so round to the nearest one.
+    uint32_t periods = (elapsed + periodUs / 2) / periodUs;
+
+    ticks += (periods - 1) * tickPeriod;
+    flags &= ~MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED;
+
+    startSystemTick(elapsed - periods * periodUs);
+}
+
+/**
+  * Brings the system time up to date after suspendSystemTick(), once the processor wakes up, and brings
+  * the scheduled system tick forward to the next tick period boundary. That tick restarts the periodic system tick.
+  * Does nothing if the system tick is not suspended.
+  */
+void MicroBit::resumeSystemTick()
+{
+    __disable_irq();
+
+    if (flags & MICROBIT_FLAG_SYSTEM_TICK_SUSPENDED)
+    {
+        uint32_t periodUs = tickPeriod * 1000;
+        uint32_t elapsed = us_ticker_read() - tickSuspendedAt;
+
+        // We may have woken up within moments of the system tick being suspended.
+        if ((int32_t)elapsed < 0)
+            elapsed = 0;
+
+        uint32_t periods = elapsed / periodUs;
+
+        ticks += periods * tickPeriod;
+        tickSuspendedAt += periods * periodUs;
+
+        systemTicker.attach_us(this, &MicroBit::systemTick, periodUs - (elapsed - periods * periodUs));
+    }
+
+    __enable_irq();
+}
+
+/*
+ * Reconfigures the ticker to the given speed in milliseconds.
+ * @param speedMs the speed in milliseconds
+ * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMETER is returned if speedUs < 1
+ *
+ * @note this will also modify the value that is added to ticks in MiroBitFiber:scheduler_tick()
+ */
+int MicroBit::setTickPeriod(int speedMs)
+{
+    if(speedMs < 1)
+        return MICROBIT_INVALID_PARAMETER;
+
+    uint32_t lag = systemTickLag();
+
+    uBit.systemTicker.detach();
+
+    tickPeriod = speedMs;
+
+    startSystemTick(lag);
+
+    return MICROBIT_OK;
+}
+
+/*
+ * Returns the currently used tick speed in milliseconds
+ */
+int MicroBit::getTickPeriod()
+{
+    return tickPeriod;
+}
@@ -84,6 +84,15 @@ int MicroBitThermometer::isIdleCallbackNeeded()
 {
     return isSampleNeeded();    
 }
+/**
+  * Determines how long the thermometer can go without being serviced while the processor is idle.
+  * @return The time until the next temperature reading is due, in milliseconds.
+  */
+unsigned long MicroBitThermometer::systemTickPeriod()
+{
+    return isSampleNeeded() ? 0 : sampleTime - ticks;
+}
+
 /**
   * periodic callback.
   * Check once every second or so for a new temperature reading.
@@ -163,8 +172,8 @@ void MicroBitThermometer::updateTemperature()
     // Schedule our next sample.
     sampleTime = ticks + samplePeriod;
     
-    // Send an event to indicate that we'e updated our temperature.
-    MicroBitEvent e(id, MICROBIT_THERMOMETER_EVT_UPDATE);
+    // Send an event to indicate that we'e updated our temperature. Only the latest of these matters.
+    MicroBitEvent e(id, MICROBIT_THERMOMETER_EVT_UPDATE, CREATE_AND_COALESCE);
 }
 
 
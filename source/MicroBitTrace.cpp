@@ -0,0 +1,56 @@
+/**
+  * Event trace: a fixed size ring buffer of events and fiber switches, for post-mortem analysis.
+  */
+
+#include "MicroBit.h"
+
+#if CONFIG_ENABLED(MICROBIT_TRACE)
+MicroBitTraceRecord microbit_trace_buffer[MICROBIT_TRACE_RECORDS];    // The most recent records.
+uint32_t microbit_trace_count = 0;                                      // The number of records made since power on (or since the trace was cleared).
+#endif
+
+/**
+  * Writes the trace to the serial port, oldest record first, in the format read by the trace-decoder host tool.
+  * Requires MICROBIT_TRACE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_trace_dump()
+{
+#if CONFIG_ENABLED(MICROBIT_TRACE)
+    // Take the records made up to now. Anything recorded while we write them out is left for the next dump.
+    uint32_t count = microbit_trace_count;
+    uint32_t records = min(count, (uint32_t) MICROBIT_TRACE_RECORDS);
+
+    uBit.serial.printf("trace %x %x %x\n", records, count, us_ticker_read());
+
+    for (uint32_t i = count - records; i != count; i++)
+    {
+        MicroBitTraceRecord r = microbit_trace_buffer[i & (MICROBIT_TRACE_RECORDS - 1)];
+
+        uBit.serial.printf("%x %x %x %x %x\n", r.time, r.type, r.a, r.b, r.c);
+    }
+
+    uBit.serial.printf("trace end\n");
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+  * Discards all records in the trace. Requires MICROBIT_TRACE to be enabled.
+  *
+  * @return MICROBIT_OK, or MICROBIT_NOT_SUPPORTED.
+  */
+int microbit_trace_clear()
+{
+#if CONFIG_ENABLED(MICROBIT_TRACE)
+    microbit_trace_count = 0;
+
+    return MICROBIT_OK;
+#else
+    return MICROBIT_NOT_SUPPORTED;
+#endif
+}
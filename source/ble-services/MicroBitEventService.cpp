@@ -15,7 +15,7 @@
 MicroBitEventService::MicroBitEventService(BLEDevice &_ble) : 
         ble(_ble) 
 {
-    GattCharacteristic  microBitEventCharacteristic(MicroBitEventServiceMicroBitEventCharacteristicUUID, (uint8_t *)&microBitEventBuffer, 0, sizeof(EventServiceEvent), 
+    GattCharacteristic  microBitEventCharacteristic(MicroBitEventServiceMicroBitEventCharacteristicUUID, (uint8_t *)microBitEventBuffer, 0, sizeof(microBitEventBuffer), 
     GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY);
 
     GattCharacteristic  clientEventCharacteristic(MicroBitEventServiceClientEventCharacteristicUUID, (uint8_t *)&clientEventBuffer, 0, sizeof(EventServiceEvent),
@@ -30,9 +30,11 @@ MicroBitEventService::MicroBitEventService(BLEDevice &_ble) :
     clientEventBuffer.type = 0x00;
     clientEventBuffer.reason = 0x00;
     
-    microBitEventBuffer = microBitRequirementsBuffer = clientRequirementsBuffer = clientEventBuffer;
+    microBitRequirementsBuffer = clientRequirementsBuffer = clientEventBuffer;
+    memclr(microBitEventBuffer, sizeof(microBitEventBuffer));
 
     messageBusListenerOffset = 0;
+    packedEvents = false;
     
     // Set default security requirements
     microBitEventCharacteristic.requireSecurity(SecurityManager::SECURITY_MODE_ENCRYPTION_WITH_MITM);
@@ -79,7 +81,17 @@ void MicroBitEventService::onDataWritten(const GattWriteCallbackParams *params)
         // Read and register for all the events given...
         while (len >= 4)
         {
-            uBit.MessageBus.listen(e->type, e->reason, this, &MicroBitEventService::onMicroBitEvent, MESSAGE_BUS_LISTENER_IMMEDIATE);
+            // The client may instead be telling us which options it supports.
+            if (e->type == MICROBIT_EVENT_SERVICE_ID_OPTIONS)
+            {
+                packedEvents = (e->reason & MICROBIT_EVENT_SERVICE_PACKED) != 0;
+
+                len-=4;
+                e++;
+                continue;
+            }
+
+            uBit.MessageBus.listen(e->type, e->reason, this, &MicroBitEventService::onMicroBitEvent, MESSAGE_BUS_LISTENER_NONBLOCKING);
 
             len-=4;
             e++;
@@ -89,18 +101,29 @@ void MicroBitEventService::onDataWritten(const GattWriteCallbackParams *params)
 }
 
 /**
-  * Callback. Invoked when any events are sent on the microBit message bus.
+  * Callback. Invoked with the events sent on the microBit message bus since the last call, which
+  * are packed into as few notifications as possible if the client has asked for MICROBIT_EVENT_SERVICE_PACKED.
   */
-void MicroBitEventService::onMicroBitEvent(MicroBitEvent evt)
+void MicroBitEventService::onMicroBitEvent(MicroBitEvent *evt, int count)
 {
-    EventServiceEvent *e = &microBitEventBuffer;
-    
-    if (ble.getGapState().connected) {
-        e->type = evt.source;
-        e->reason = evt.value;
-        
-        ble.gattServer().notify(microBitEventCharacteristicHandle, (const uint8_t *)e, sizeof(EventServiceEvent));
-    } 
+    if (!ble.getGapState().connected)
+        return;
+
+    while (count > 0)
+    {
+        int n = packedEvents ? min(count, MICROBIT_EVENT_SERVICE_MAX_EVENTS) : 1;
+
+        for (int i = 0; i < n; i++)
+        {
+            microBitEventBuffer[i].type = evt[i].source;
+            microBitEventBuffer[i].reason = evt[i].value;
+        }
+
+        ble.gattServer().notify(microBitEventCharacteristicHandle, (const uint8_t *)microBitEventBuffer, n * sizeof(EventServiceEvent));
+
+        evt += n;
+        count -= n;
+    }
 }
 
 /**
@@ -109,12 +132,24 @@ void MicroBitEventService::onMicroBitEvent(MicroBitEvent evt)
  */  
 void MicroBitEventService::idleTick()
 {
+    if (!ble.getGapState().connected)
+        packedEvents = false;
+
     if (!ble.getGapState().connected && messageBusListenerOffset >0) {
         messageBusListenerOffset = 0;  
         uBit.MessageBus.ignore(MICROBIT_ID_ANY, MICROBIT_EVT_ANY, this, &MicroBitEventService::onMicroBitEvent);
     }
 }
 
+/**
+ * Disconnection is signalled by the BLE stack, which wakes the processor anyway,
+ * so no system ticks are needed while the processor is idle.
+ */
+unsigned long MicroBitEventService::systemTickPeriod()
+{
+    return MICROBIT_TICK_PERIOD_UNLIMITED;
+}
+
 /**
  * read callback on data characteristic.
  * reads all the pins marked as inputs, and updates the data stored in the BLE stack.
@@ -249,6 +249,14 @@ void MicroBitIOPinService::idleTick()
         ble.gattServer().notify(ioPinServiceDataCharacteristic->getValueHandle(), (uint8_t *)ioPinServiceDataCharacteristicBuffer, pairs * sizeof(IOData));
 }
 
+/**
+ * Pins are polled on every system tick whilst a client is connected, but not otherwise.
+ */
+unsigned long MicroBitIOPinService::systemTickPeriod()
+{
+    return ble.getGapState().connected ? 0 : MICROBIT_TICK_PERIOD_UNLIMITED;
+}
+
 const uint8_t  MicroBitIOPinServiceUUID[] = {
     0xe9,0x5d,0x12,0x7b,0x25,0x1d,0x47,0x0a,0xa0,0x62,0xfa,0x19,0x22,0xdf,0xa9,0xa8
 };
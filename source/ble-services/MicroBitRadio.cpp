@@ -328,6 +328,17 @@ void MicroBitRadio::idleTick()
     }
 }
 
+/**
+  * Packets are received by an interrupt handler, which wakes the processor anyway, so the radio
+  * needs no system ticks while the processor is idle.
+  *
+  * @return MICROBIT_TICK_PERIOD_UNLIMITED.
+  */
+unsigned long MicroBitRadio::systemTickPeriod()
+{
+    return MICROBIT_TICK_PERIOD_UNLIMITED;
+}
+
 /**
   * Determines the number of packets ready to be processed.
   * @return The number of packets in the receive buffer.